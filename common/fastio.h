@@ -0,0 +1,131 @@
+// Fast input for the simulators: a file is mapped read-only in one piece and
+// numbers are parsed by hand instead of through iostream extraction.
+#ifndef FASTIO_H
+#define FASTIO_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+// Read-only view of a whole file. An empty or missing file maps to an empty
+// range, which parses like an empty stream.
+class MappedFile {
+   public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data = static_cast<const char*>(addr);
+                size = st.st_size;
+                madvise(addr, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) munmap(const_cast<char*>(data), size);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+
+    // drops the whole pages before `upto` from this process, so a long
+    // sequential read keeps a bounded resident set; the pages come back from
+    // the page cache if they are read again
+    void release(const char* upto) {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t offset = (upto - data) / page * page;
+        if (offset <= released) return;
+        madvise(const_cast<char*>(data) + released, offset - released,
+                MADV_DONTNEED);
+        released = offset;
+    }
+
+   private:
+    const char* data = nullptr;
+    size_t size = 0;
+    size_t released = 0;
+};
+
+// Cursor over a character range with the same whitespace and number rules as
+// `stream >> value`, minus locale handling.
+class Scanner {
+   public:
+    Scanner(const char* pos, const char* end) : pos(pos), end(end) {}
+    explicit Scanner(const MappedFile& file)
+        : pos(file.begin()), end(file.end()) {}
+
+    bool at_end() const { return pos == end; }
+    const char* position() const { return pos; }
+
+    // next whitespace separated integer; false, leaving value untouched, at
+    // the end of the range or if no digits follow
+    template <typename T>
+    bool next(T& value) {
+        skip_space();
+        const char* p = pos;
+        bool negative = false;
+        if (p != end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            p++;
+        }
+        if (p == end || !is_digit(*p)) return false;
+        T result = 0;
+        while (p != end && is_digit(*p)) {
+            result = result * 10 + (*p - '0');
+            p++;
+        }
+        value = negative ? -result : result;
+        pos = p;
+        return true;
+    }
+
+    // next non-whitespace character, like extracting into a char
+    bool next_char(char& c) {
+        skip_space();
+        if (pos == end) return false;
+        c = *pos++;
+        return true;
+    }
+
+    // splits off the next line, without its '\n', like std::getline
+    bool next_line(Scanner& line) {
+        if (pos == end) return false;
+        const char* start = pos;
+        const char* newline =
+            static_cast<const char*>(memchr(pos, '\n', end - pos));
+        pos = newline ? newline : end;
+        line = Scanner(start, pos);
+        if (pos != end) pos++;
+        return true;
+    }
+
+    // first character of the range, 0 if it is empty
+    char front() const { return pos == end ? 0 : *pos; }
+
+   private:
+    const char* pos;
+    const char* end;
+
+    static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+    static bool is_space(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    void skip_space() {
+        while (pos != end && is_space(*pos)) pos++;
+    }
+};
+
+#endif
@@ -0,0 +1,82 @@
+// The random number table shared by the simulators. A text rfile (a count
+// followed by the numbers) is parsed into memory; a precompiled rfile (see
+// rfile2bin) is mapped read-only and used in place, so concurrent runs share
+// the page cache copy and start without parsing anything.
+#ifndef RANDTABLE_H
+#define RANDTABLE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "fastio.h"
+
+// Precompiled layout: RandomTableHeader, then count native-endian uint32s.
+struct RandomTableHeader {
+    char magic[4];  // "RNDB"
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+class RandomTable {
+   public:
+    explicit RandomTable(const std::string& filename) : file(filename) {
+        size_t size = file.end() - file.begin();
+        RandomTableHeader header;
+        if (size >= sizeof(header)) {
+            memcpy(&header, file.begin(), sizeof(header));
+        }
+        if (size >= sizeof(header) && !memcmp(header.magic, "RNDB", 4)) {
+            if (header.version != 1 ||
+                size < sizeof(header) + header.count * sizeof(uint32_t)) {
+                printf("Invalid precompiled random file. Exiting.\n");
+                exit(EXIT_FAILURE);
+            }
+            values = reinterpret_cast<const uint32_t*>(file.begin() +
+                                                       sizeof(header));
+            n_values = header.count;
+            return;
+        }
+
+        Scanner in(file);
+        uint32_t number = 0;
+        in.next(number);  // first number is the number of random numbers
+        parsed.reserve(number);
+        while (in.next(number)) {
+            parsed.push_back(number);
+        }
+        values = parsed.data();
+        n_values = parsed.size();
+    }
+
+    RandomTable(const RandomTable&) = delete;
+    RandomTable& operator=(const RandomTable&) = delete;
+
+    size_t size() const { return n_values; }
+    uint32_t operator[](size_t i) const { return values[i]; }
+
+    // writes the table in the precompiled layout, false on an I/O error
+    bool save(const std::string& filename) const {
+        FILE* out = fopen(filename.c_str(), "wb");
+        if (!out) return false;
+        RandomTableHeader header = {};
+        memcpy(header.magic, "RNDB", 4);
+        header.version = 1;
+        header.count = n_values;
+        bool ok = fwrite(&header, sizeof(header), 1, out) == 1 &&
+                  fwrite(values, sizeof(uint32_t), n_values, out) == n_values;
+        return fclose(out) == 0 && ok;
+    }
+
+   private:
+    MappedFile file;
+    std::vector<uint32_t> parsed;  // text rfiles only
+    const uint32_t* values = nullptr;
+    size_t n_values = 0;
+};
+
+#endif
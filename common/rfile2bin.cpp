@@ -0,0 +1,24 @@
+// Precompiles a text rfile into the layout RandomTable maps in place:
+//
+//   make && ./rfile2bin <rfile> <binfile>
+#include <cstdio>
+#include <cstdlib>
+
+#include "randtable.h"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <rfile> <binfile>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    RandomTable table(argv[1]);
+    if (table.size() == 0) {
+        printf("No random numbers in %s. Exiting.\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+    if (!table.save(argv[2])) {
+        printf("Cannot write %s. Exiting.\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+}
@@ -1,14 +1,14 @@
 #include <unistd.h>
 
-#include <fstream>
 #include <iostream>
 #include <list>
-#include <sstream>
 #include <string>
 #include <vector>
 #include <limits>
 #include <algorithm>
 
+#include "../../common/fastio.h"
+
 struct io_operation {
     int arr_time;
     int track;
@@ -39,16 +39,15 @@ int simul_time = 0;
 Scheduler *sched;
 
 void read_input_file(const std::string &filename) {
-    std::ifstream file(filename);
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') {
+    MappedFile file(filename);
+    Scanner in(file), line(nullptr, nullptr);
+    while (in.next_line(line)) {
+        if (line.at_end() || line.front() == '#') {
             continue;
         }
 
-        std::istringstream iss(line);
-        int arr_time, track;
-        iss >> arr_time >> track;
+        int arr_time = 0, track = 0;
+        line.next(arr_time) && line.next(track);
         io_operations.push_back(io_operation(arr_time, track));
     }
 }
@@ -3,7 +3,7 @@ use std::cell::RefCell;
 use std::collections::VecDeque;
 use std::rc::Rc;
 mod utils;
-use utils::{read_input_file, read_random_file};
+use utils::{read_input_file, read_random_file, RandomTable};
 
 // Define a struct to hold the flags
 #[derive(Debug, Default)]
@@ -240,11 +240,11 @@ impl Pager for FIFO {
 struct Random {
     hand: usize,
     num_frames: usize,
-    random_numbers: Vec<usize>,
+    random_numbers: RandomTable,
 }
 
 impl Random {
-    fn new(frame_table: Rc<RefCell<Vec<Option<Frame>>>>, random_numbers: Vec<usize>) -> Random {
+    fn new(frame_table: Rc<RefCell<Vec<Option<Frame>>>>, random_numbers: RandomTable) -> Random {
         let num_frames = frame_table.borrow().len();
         Random {
             hand: 0,
@@ -256,7 +256,7 @@ impl Random {
 
 impl Pager for Random {
     fn select_victim_frame(&mut self, _instr_idx: usize) -> usize {
-        let frame = self.random_numbers[self.hand] % self.num_frames;
+        let frame = self.random_numbers.get(self.hand) % self.num_frames;
         self.hand = (self.hand + 1) % self.random_numbers.len();
         frame
     }
@@ -1,6 +1,7 @@
 use crate::{Process, VMA};
 use std::fs::File;
-use std::io::{BufRead, BufReader};
+use std::io::{BufRead, BufReader, Read, Seek, SeekFrom};
+use std::os::unix::io::AsRawFd;
 
 pub fn read_input_file(filename: &str) -> (Vec<Process>, Vec<(String, usize)>) {
     let file = File::open(filename).expect("Failed to open file");
@@ -79,9 +80,90 @@ pub fn read_input_file(filename: &str) -> (Vec<Process>, Vec<(String, usize)>) {
     (processes, instructions)
 }
 
-pub fn read_random_file(filename: &str) -> Vec<usize> {
+/// The random numbers of an rfile: parsed from the text format, or mapped in
+/// place from a precompiled one (common/rfile2bin) so that concurrent runs
+/// share the page cache copy.
+pub enum RandomTable {
+    Parsed(Vec<usize>),
+    Mapped(&'static [u32]),
+}
+
+impl RandomTable {
+    pub fn get(&self, i: usize) -> usize {
+        match self {
+            RandomTable::Parsed(numbers) => numbers[i],
+            RandomTable::Mapped(numbers) => numbers[i] as usize,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        match self {
+            RandomTable::Parsed(numbers) => numbers.len(),
+            RandomTable::Mapped(numbers) => numbers.len(),
+        }
+    }
+}
+
+mod ffi {
+    use std::os::raw::{c_int, c_long, c_void};
+
+    pub const PROT_READ: c_int = 1;
+    pub const MAP_PRIVATE: c_int = 2;
+
+    extern "C" {
+        pub fn mmap(
+            addr: *mut c_void,
+            len: usize,
+            prot: c_int,
+            flags: c_int,
+            fd: c_int,
+            offset: c_long,
+        ) -> *mut c_void;
+    }
+}
+
+// header of a precompiled rfile: "RNDB", version, count, reserved
+const RANDOM_TABLE_HEADER: usize = 16;
+
+fn map_random_file(file: &File) -> &'static [u32] {
+    let len = file.metadata().expect("Failed to stat file").len() as usize;
+    // the mapping lives as long as the program, like the table it replaces
+    let addr = unsafe {
+        ffi::mmap(
+            std::ptr::null_mut(),
+            len,
+            ffi::PROT_READ,
+            ffi::MAP_PRIVATE,
+            file.as_raw_fd(),
+            0,
+        )
+    };
+    if addr as isize == -1 {
+        panic!("Failed to map the random file");
+    }
+    let bytes = unsafe { std::slice::from_raw_parts(addr as *const u8, len) };
+    let field = |i: usize| u32::from_ne_bytes(bytes[4 * i..4 * i + 4].try_into().unwrap());
+    assert_eq!(field(1), 1, "Unsupported random file version");
+    let count = field(2) as usize;
+    assert!(
+        len >= RANDOM_TABLE_HEADER + 4 * count,
+        "Truncated random file"
+    );
+    unsafe {
+        std::slice::from_raw_parts(bytes[RANDOM_TABLE_HEADER..].as_ptr() as *const u32, count)
+    }
+}
+
+pub fn read_random_file(filename: &str) -> RandomTable {
+    let mut file = File::open(filename).expect("Failed to open file");
+    let mut magic = [0u8; 4];
+    if file.read_exact(&mut magic).is_ok() && &magic == b"RNDB" {
+        return RandomTable::Mapped(map_random_file(&file));
+    }
+    file.seek(SeekFrom::Start(0))
+        .expect("Failed to rewind file");
+
     // The format is: the 1st line is the number of random numbers, and the rest are the numbers
-    let file = File::open(filename).expect("Failed to open file");
     let reader = BufReader::new(file);
 
     let mut lines = reader.lines();
@@ -103,5 +185,5 @@ pub fn read_random_file(filename: &str) -> Vec<usize> {
         random_numbers.push(number);
     }
 
-    random_numbers
+    RandomTable::Parsed(random_numbers)
 }
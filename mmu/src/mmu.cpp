@@ -2,18 +2,24 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <fstream>
 #include <iostream>
 #include <queue>
-#include <sstream>
 #include <string>
 #include <vector>
 
+#include "../../common/fastio.h"
+#include "../../common/randtable.h"
+#include "mtrace.h"
+#include "stackdist.h"
+
 // constants
-#define MAX_FRAMES 128
-#define MAX_VPAGES 64
+#define FRAME_BITS 25  // width of pte_t::frame_number
+#define MAX_FRAMES (1 << FRAME_BITS)
+#define LAB_VPAGES 64  // address space of the lab inputs, shown by -oP/-ox
+#define CURVE_BLOCK 4096  // instructions per lock-step block of run_curve
 
 bool O_option;
 bool P_option;
@@ -84,12 +90,12 @@ bool a_option;
 // basic classes
 typedef struct {
     int pid;
-    uint16_t virtual_page_number;
-    uint32_t age;
+    uint64_t virtual_page_number;
+    uint64_t age;  // aging bits, or the instruction of the last reference
 } frame_t;
 
 typedef struct {
-    unsigned frame_number : 7;
+    unsigned frame_number : FRAME_BITS;
     unsigned valid : 1;
     unsigned referenced : 1;
     unsigned modified : 1;
@@ -97,24 +103,114 @@ typedef struct {
     unsigned write_protected : 1;
     unsigned file_mapped : 1;
     unsigned is_valid_vma : 1;
-    unsigned other : 17;
 } pte_t;
 
-struct PageTable {
-    pte_t entries[MAX_VPAGES];
+// Four-level radix page table over 36-bit virtual page numbers, i.e. 48-bit
+// addresses with 4K pages, split 9 bits per level like x86-64. Interior nodes
+// and leaves are allocated when a page below them is first mapped, so memory
+// follows the touched pages rather than the size of the address space.
+class PageTable {
+   public:
+    static const int level_bits = 9;
+    static const int levels = 4;
+    static const uint64_t fanout = 1 << level_bits;
+    static const uint64_t max_vpages = 1ULL << (level_bits * levels);
+
+    PageTable() {}
+    ~PageTable() { release(&root, levels - 1); }
+
+    PageTable(const PageTable &) = delete;
+    PageTable &operator=(const PageTable &) = delete;
+
+    // the entry of a page, nullptr if nothing around it was ever mapped
+    pte_t *find(uint64_t vpn) {
+        if (vpn >= max_vpages) return nullptr;
+        Node *node = &root;
+        for (int level = levels - 1; level > 1; level--) {
+            node = static_cast<Node *>(node->children[index(vpn, level)]);
+            if (!node) return nullptr;
+        }
+        Leaf *leaf = static_cast<Leaf *>(node->children[index(vpn, 1)]);
+        return leaf ? &leaf->entries[index(vpn, 0)] : nullptr;
+    }
+
+    // the entry of a page, allocating the path to it on first use
+    pte_t *entry(uint64_t vpn) {
+        Node *node = &root;
+        for (int level = levels - 1; level > 1; level--) {
+            void *&child = node->children[index(vpn, level)];
+            if (!child) child = new Node();
+            node = static_cast<Node *>(child);
+        }
+        void *&leaf = node->children[index(vpn, 1)];
+        if (!leaf) leaf = new Leaf();
+        return &static_cast<Leaf *>(leaf)->entries[index(vpn, 0)];
+    }
+
+    // f(vpn, pte) for every allocated entry, in ascending page order
+    template <typename F>
+    void for_each(F f) {
+        walk(&root, levels - 1, 0, f);
+    }
+
+   private:
+    struct Node {
+        void *children[fanout] = {};  // Nodes, Leafs below level 1
+    };
+    struct Leaf {
+        pte_t entries[fanout] = {};
+    };
+
+    Node root;
+
+    static uint64_t index(uint64_t vpn, int level) {
+        return (vpn >> (level * level_bits)) & (fanout - 1);
+    }
+
+    template <typename F>
+    static void walk(Node *node, int level, uint64_t base, F &f) {
+        for (uint64_t i = 0; i < fanout; i++) {
+            void *child = node->children[i];
+            if (!child) continue;
+            uint64_t child_base = (base << level_bits) | i;
+            if (level > 1) {
+                walk(static_cast<Node *>(child), level - 1, child_base, f);
+                continue;
+            }
+            Leaf *leaf = static_cast<Leaf *>(child);
+            for (uint64_t j = 0; j < fanout; j++) {
+                f((child_base << level_bits) | j, &leaf->entries[j]);
+            }
+        }
+    }
+
+    static void release(Node *node, int level) {
+        for (uint64_t i = 0; i < fanout; i++) {
+            void *child = node->children[i];
+            if (!child) continue;
+            if (level > 1) {
+                release(static_cast<Node *>(child), level - 1);
+                delete static_cast<Node *>(child);
+            } else {
+                delete static_cast<Leaf *>(child);
+            }
+        }
+    }
 };
 
 struct VirtualMemoryArea {
-    uint16_t start;
-    uint16_t end;
+    uint64_t start;
+    uint64_t end;
     bool write_protected;
     bool file_mapped;
 };
 
 struct Process {
-    std::vector<VirtualMemoryArea> virtual_memory_areas;
+    std::vector<VirtualMemoryArea> virtual_memory_areas;  // sorted by start
     PageTable page_table;
     uint16_t n_vmas;
+    uint64_t n_vpages;  // pages shown by -oP/-ox: LAB_VPAGES or up to the
+                        // highest VMA
 
     // stats
     uint64_t unmaps;
@@ -126,30 +222,139 @@ struct Process {
     uint64_t zeros;
     uint64_t segv;
     uint64_t segprot;
+
+    // binary search over the sorted, non-overlapping VMAs
+    const VirtualMemoryArea *find_vma(uint64_t virtual_page_number) const {
+        auto vma = std::upper_bound(
+            virtual_memory_areas.begin(), virtual_memory_areas.end(),
+            virtual_page_number,
+            [](uint64_t vpn, const VirtualMemoryArea &vma) {
+                return vpn < vma.start;
+            });
+        if (vma == virtual_memory_areas.begin()) return nullptr;
+        --vma;
+        return virtual_page_number <= vma->end ? &*vma : nullptr;
+    }
+};
+
+// next line that is not a comment, false at the end of the file
+bool next_input_line(Scanner &file, Scanner &line) {
+    while (file.next_line(line)) {
+        if (line.front() == '#') continue;
+        return true;
+    }
+    return false;
+}
+
+// The instructions of the input file, decoded one at a time as the simulator
+// asks for them instead of being loaded up front. Consumed pages of the
+// mapping are released as the cursor moves on, so memory stays flat however
+// long the trace is.
+class InstructionStream {
+   public:
+    static const size_t release_interval = 16 << 20;
+
+    InstructionStream(MappedFile *file, const char *position)
+        : file(file), released(position) {}
+    virtual ~InstructionStream() { delete file; }
+
+    InstructionStream(const InstructionStream &) = delete;
+    InstructionStream &operator=(const InstructionStream &) = delete;
+
+    // next instruction, false at the end of the trace
+    virtual bool next(char &operation, uint64_t &value) = 0;
+
+   protected:
+    void consumed(const char *position) {
+        if (position - released >= (ptrdiff_t)release_interval) {
+            released = position;
+            file->release(released);
+        }
+    }
+
+   private:
+    MappedFile *file;
+    const char *released;
+};
+
+// instruction lines of a text input, from where the process section ended
+class TextInstructions : public InstructionStream {
+   public:
+    TextInstructions(MappedFile *file, const Scanner &in)
+        : InstructionStream(file, in.position()), in(in) {}
+
+    // a line without an instruction repeats the previous one, as the vector
+    // reader did
+    bool next(char &operation, uint64_t &value) override {
+        if (!next_input_line(in, line)) return false;
+        line.next_char(instruction) && line.next(argument);
+        operation = instruction;
+        value = argument;
+        consumed(in.position());
+        return true;
+    }
+
+   private:
+    Scanner in;
+    Scanner line = Scanner(nullptr, nullptr);
+    char instruction = 0;
+    uint64_t argument = 0;
+};
+
+// packed instructions of a binary trace (see mtrace.h)
+class BinaryInstructions : public InstructionStream {
+   public:
+    BinaryInstructions(MappedFile *file, const char *position,
+                       uint64_t n_instructions)
+        : InstructionStream(file, position),
+          decoder(position, file->end()),
+          n_left(n_instructions) {}
+
+    bool next(char &operation, uint64_t &value) override {
+        if (!decoder.next(operation, value)) {
+            if (n_left != 0) {
+                printf("Truncated binary trace. Exiting.\n");
+                exit(EXIT_FAILURE);
+            }
+            return false;
+        }
+        n_left--;
+        consumed(decoder.position());
+        return true;
+    }
+
+   private:
+    TraceDecoder decoder;
+    uint64_t n_left;
 };
 
 // global variables
-uint16_t n_frames;
+uint32_t n_frames;
 uint64_t n_random;
-uint32_t n_instructions;
-uint32_t instruction_idx = 0;
-frame_t frame_table[MAX_FRAMES];
-std::queue<uint16_t> free_frame_list;
+uint64_t n_instructions = 0;
+uint64_t instruction_idx = 0;
+std::vector<frame_t> frame_table;
+std::queue<uint32_t> free_frame_list;
 std::vector<Process *> processes;
-std::vector<std::pair<char, uint32_t> > instructions;
-std::vector<uint32_t> random_numbers;
+InstructionStream *instructions = nullptr;
+RandomTable *random_numbers = nullptr;
+
+// page table entry of the page held by a frame
+pte_t *frame_pte(const frame_t *frame) {
+    return processes[frame->pid]->page_table.entry(frame->virtual_page_number);
+}
 
 class Pager {
    public:
-    uint16_t hand = 0;
-    virtual uint16_t select_victim_frame() = 0;
+    uint32_t hand = 0;
+    virtual uint32_t select_victim_frame() = 0;
     virtual void update_age(frame_t *frame) { ; };
 };
 
 class FIFO : public Pager {
    public:
-    uint16_t select_victim_frame() override {
-        uint16_t frame = hand;
+    uint32_t select_victim_frame() override {
+        uint32_t frame = hand;
         // a_trace("ASELECT %d", frame % n_frames);
         hand = (hand + 1) % n_frames;
         return frame;
@@ -157,8 +362,8 @@ class FIFO : public Pager {
 };
 class Random : public Pager {
    public:
-    uint16_t select_victim_frame() override {
-        uint16_t frame = random_numbers[hand] % n_frames;
+    uint32_t select_victim_frame() override {
+        uint32_t frame = (*random_numbers)[hand] % n_frames;
         // a_trace("ASELECT %d", frame); // random pager doesn't implement
         // a_trace
         hand = (hand + 1) % n_random;
@@ -168,12 +373,11 @@ class Random : public Pager {
 
 class Clock : public Pager {
    public:
-    uint16_t select_victim_frame() override {
-        uint16_t i = hand;
+    uint32_t select_victim_frame() override {
+        uint32_t i = hand;
         while (true) {
             frame_t *frame = &frame_table[i % n_frames];
-            pte_t *pte = &processes[frame->pid]
-                              ->page_table.entries[frame->virtual_page_number];
+            pte_t *pte = frame_pte(frame);
             if (pte->referenced) {
                 pte->referenced = false;
                 i++;
@@ -188,9 +392,9 @@ class Clock : public Pager {
 
 class NRU : public Pager {
    public:
-    uint32_t instruction_ckpt = 0;
-    uint16_t select_victim_frame() override {
-        uint16_t i = hand;
+    uint64_t instruction_ckpt = 0;
+    uint32_t select_victim_frame() override {
+        uint32_t i = hand;
         int reset = 0;
         int class_ = -1;
         int classes[4] = {-1, -1, -1, -1};
@@ -200,8 +404,7 @@ class NRU : public Pager {
         }
         while (true) {
             frame_t *frame = &frame_table[i % n_frames];
-            pte_t *pte = &processes[frame->pid]
-                              ->page_table.entries[frame->virtual_page_number];
+            pte_t *pte = frame_pte(frame);
 
             class_ = (pte->referenced << 1) + pte->modified;
             if (classes[class_] == -1) {
@@ -223,7 +426,7 @@ class NRU : public Pager {
 
         for (int j = 0; j < 4; j++) {
             if (classes[j] > -1) {
-                uint16_t selected_frame = classes[j];
+                uint32_t selected_frame = classes[j];
                 // a_trace("ASELECT: hand=%2d %d | %d %2d %2d", hand, reset, j,
                 // selected_frame, i - hand + 1);
                 hand = (selected_frame + 1) % n_frames;
@@ -236,16 +439,15 @@ class NRU : public Pager {
 class Aging : public Pager {
    public:
     void update_age(frame_t *frame) override { frame->age = 0; }
-    uint16_t select_victim_frame() override {
-        uint16_t i = hand;
+    uint32_t select_victim_frame() override {
+        uint32_t i = hand;
         uint32_t min_age = 0xffffffff;
         int min_age_frame = -1;
         // std::string frame_str = "";
         // char buffer[100];
         while (true) {
             frame_t *frame = &frame_table[i % n_frames];
-            pte_t *pte = &processes[frame->pid]
-                              ->page_table.entries[frame->virtual_page_number];
+            pte_t *pte = frame_pte(frame);
 
             frame->age = frame->age >> 1;
             if (pte->referenced) {
@@ -280,16 +482,15 @@ class WorkingSet : public Pager {
    public:
     const uint16_t tau = 50;
     void update_age(frame_t *frame) override { frame->age = instruction_idx; }
-    uint16_t select_victim_frame() override {
-        uint16_t i = hand;
-        uint32_t min_age = instruction_idx;
-        uint16_t min_age_frame = hand;
+    uint32_t select_victim_frame() override {
+        uint32_t i = hand;
+        uint64_t min_age = instruction_idx;
+        uint32_t min_age_frame = hand;
         // std::string frame_str = "";
         // char buffer[100];
         while (true) {
             frame_t *frame = &frame_table[i % n_frames];
-            pte_t *pte = &processes[frame->pid]
-                              ->page_table.entries[frame->virtual_page_number];
+            pte_t *pte = frame_pte(frame);
             // sprintf(buffer, " %d(%d %d:%d %d)", i % n_frames,
             // pte->referenced,
             //         frame->pid, frame->virtual_page_number, frame->age);
@@ -342,9 +543,11 @@ std::string page_table_str(int pid) {
     std::string outstring = "PT[" + std::to_string(pid) + "]:";
     Process *process = processes[pid];
 
-    for (int i = 0; i < MAX_VPAGES; i++) {
-        pte_t *pte = &process->page_table.entries[i];
-        if (pte->paged_out && !pte->valid && !pte->file_mapped) {
+    for (uint64_t i = 0; i < process->n_vpages; i++) {
+        pte_t *pte = process->page_table.find(i);
+        if (!pte) {
+            outstring += " *";
+        } else if (pte->paged_out && !pte->valid && !pte->file_mapped) {
             outstring += " #";
         } else if (!pte->is_valid_vma || !pte->valid) {
             outstring += " *";
@@ -378,42 +581,37 @@ class Simulator {
     int instruction;
 
     // stats
-    uint32_t process_exits = 0;
-    uint32_t ctx_switches = 0;
+    uint64_t process_exits = 0;
+    uint64_t ctx_switches = 0;
 
    public:
     Simulator(Pager *pager) {
         this->pager = pager;
 
         // initialize frame table
-        for (frame_t &frame : frame_table) {
-            frame.pid = -1;
-            frame.virtual_page_number = -1;
-            frame.age = 0;
-        }
+        frame_table.assign(n_frames, frame_t{-1, (uint64_t)-1, 0});
 
         // initialize free frame list
-        for (uint16_t i = 0; i < n_frames; i++) {
+        for (uint32_t i = 0; i < n_frames; i++) {
             free_frame_list.push(i);
         }
     }
 
-    uint16_t get_frame() {
+    uint32_t get_frame() {
         // if there is a free frame, return it
         if (!free_frame_list.empty()) {
-            uint16_t frame_idx = free_frame_list.front();
+            uint32_t frame_idx = free_frame_list.front();
             free_frame_list.pop();
             return frame_idx;
         }
 
         // otherwise, select a victim frame
-        uint16_t victim_frame_idx = pager->select_victim_frame();
+        uint32_t victim_frame_idx = pager->select_victim_frame();
         frame_t *victim_frame = &frame_table[victim_frame_idx];
         Process *victim_process = processes[victim_frame->pid];
-        pte_t *victim_pte = &victim_process->page_table
-                                 .entries[victim_frame->virtual_page_number];
+        pte_t *victim_pte = frame_pte(victim_frame);
 
-        O_trace(" UNMAP %d:%d", victim_frame->pid,
+        O_trace(" UNMAP %d:%lu", victim_frame->pid,
                 victim_frame->virtual_page_number);
         victim_process->unmaps++;
 
@@ -433,30 +631,28 @@ class Simulator {
         return victim_frame_idx;
     }
 
-    int page_fault_handler(uint16_t virtual_page_number) {
+    int page_fault_handler(uint64_t virtual_page_number) {
         Process *current_process = processes[current_pid];
-        pte_t *pte = &current_process->page_table.entries[virtual_page_number];
-
-        // check if the page is valid vma
-        bool is_valid_vma = false;
-        for (const auto &vma : current_process->virtual_memory_areas) {
-            if (virtual_page_number >= vma.start &&
-                virtual_page_number <= vma.end) {
-                is_valid_vma = true;
-                pte->is_valid_vma = is_valid_vma;
-                pte->file_mapped = vma.file_mapped;
-                pte->write_protected = vma.write_protected;
-                break;
+        pte_t *pte = current_process->page_table.find(virtual_page_number);
+
+        // check if the page is valid vma; VMAs never change, so a page keeps
+        // the attributes it got on its first fault and needs no lookup later
+        if (!pte || !pte->is_valid_vma) {
+            const VirtualMemoryArea *vma =
+                current_process->find_vma(virtual_page_number);
+            if (!vma) {
+                O_trace(" SEGV");
+                current_process->segv++;
+                return 1;  // signal error
             }
-        }
-        if (!is_valid_vma) {
-            O_trace(" SEGV");
-            current_process->segv++;
-            return 1;  // signal error
+            pte = current_process->page_table.entry(virtual_page_number);
+            pte->is_valid_vma = true;
+            pte->file_mapped = vma->file_mapped;
+            pte->write_protected = vma->write_protected;
         }
 
         // all valid get a free frame
-        uint16_t frame_idx = get_frame();
+        uint32_t frame_idx = get_frame();
         frame_t *frame = &frame_table[frame_idx];
 
         // initialize the page table entry
@@ -484,68 +680,74 @@ class Simulator {
         return 0;  // signal success
     }
 
-    void run() {
-        for (int i = 0; i < n_instructions; i++) {
-            instruction_idx = i;
-            char operation = instructions[i].first;
-            int value = instructions[i].second;
-            // Process *process = processes[value];
-            // PageTable *page_table = &process->page_table;
-
-            O_trace("%d: ==> %c %d", i, operation, value);
-            if (operation == 'c') {
-                current_pid = value;
-                ctx_switches++;
-                continue;
-            } else if (operation == 'e') {
-                O_trace("EXIT current process %d", value);
-                process_exits++;
-                Process *process = processes[current_pid];
-                for (int i = 0; i < MAX_VPAGES; i++) {
-                    pte_t *pte = &process->page_table.entries[i];
-                    if (pte->valid) {
-                        O_trace(" UNMAP %d:%d", current_pid, i);
-                        process->unmaps++;
-                        frame_t *frame = &frame_table[pte->frame_number];
-                        frame->pid = -1;
-                        frame->virtual_page_number = -1;
-                        frame->age = 0;
-                        free_frame_list.push(pte->frame_number);
-                        if (pte->modified && pte->file_mapped) {
-                            O_trace(" FOUT");
-                            process->fouts++;
-                        }
+    // executes one instruction; instruction_idx is its index
+    void step(char operation, uint64_t value) {
+        O_trace("%lu: ==> %c %lu", instruction_idx, operation, value);
+        if (operation == 'c') {
+            current_pid = value;
+            ctx_switches++;
+            return;
+        } else if (operation == 'e') {
+            O_trace("EXIT current process %lu", value);
+            process_exits++;
+            Process *process = processes[current_pid];
+            process->page_table.for_each([&](uint64_t vpn, pte_t *pte) {
+                if (pte->valid) {
+                    O_trace(" UNMAP %d:%lu", current_pid, vpn);
+                    process->unmaps++;
+                    frame_t *frame = &frame_table[pte->frame_number];
+                    frame->pid = -1;
+                    frame->virtual_page_number = -1;
+                    frame->age = 0;
+                    free_frame_list.push(pte->frame_number);
+                    if (pte->modified && pte->file_mapped) {
+                        O_trace(" FOUT");
+                        process->fouts++;
                     }
-                    pte->valid = false;
-                    pte->paged_out = false;
                 }
-                continue;
-            } else if (operation == 'r' || operation == 'w') {
-                Process *process = processes[current_pid];
-                pte_t *pte = &process->page_table.entries[value];
-
-                // check if the page is valid
-                if (!pte->valid) {
-                    if (page_fault_handler(value)) {
-                        continue;
-                    }
+                pte->valid = false;
+                pte->paged_out = false;
+            });
+            return;
+        } else if (operation == 'r' || operation == 'w') {
+            Process *process = processes[current_pid];
+            pte_t *pte = process->page_table.find(value);
+
+            // check if the page is valid
+            if (!pte || !pte->valid) {
+                if (page_fault_handler(value)) {
+                    return;
                 }
+                pte = process->page_table.find(value);
+            }
 
-                pte->referenced = true;
-                if (operation == 'w') {
-                    if (pte->write_protected) {
-                        O_trace(" SEGPROT");
-                        process->segprot++;
-                    } else {
-                        pte->modified = true;
-                    }
+            pte->referenced = true;
+            if (operation == 'w') {
+                if (pte->write_protected) {
+                    O_trace(" SEGPROT");
+                    process->segprot++;
+                } else {
+                    pte->modified = true;
                 }
-                x_trace("%s", page_table_str(current_pid).c_str());
-                f_trace("%s", frame_table_str().c_str());
             }
+            x_trace("%s", page_table_str(current_pid).c_str());
+            f_trace("%s", frame_table_str().c_str());
         }
+    }
 
-        // print summary
+    void run() {
+        char operation;
+        uint64_t value;
+        for (uint64_t i = 0; instructions->next(operation, value); i++) {
+            instruction_idx = i;
+            n_instructions = i + 1;
+            step(operation, value);
+        }
+        summary();
+    }
+
+    // the -oP/-oF/-oS output after the last instruction
+    void summary() {
         if (P_option) {
             for (int i = 0; i < processes.size(); i++) {
                 P_trace("%s", page_table_str(i).c_str());
@@ -578,105 +780,317 @@ class Simulator {
 
 // functions
 void read_random_file(const std::string &randomfile) {
-    // Function that takes the name of a file with random numbers and stores
-    // them in a global variable called random_values
-    std::ifstream rfile(randomfile);
-    rfile >> n_random;
-    uint32_t number;
-    while (rfile >> number) {
-        random_numbers.push_back(number);
+    // Function that takes the name of a file with random numbers, text or
+    // precompiled, and loads them into the global random_numbers table
+    random_numbers = new RandomTable(randomfile);
+    n_random = random_numbers->size();
+}
+
+// loads the processes of a binary trace and positions the instruction
+// stream after them
+void read_binary_trace(MappedFile *file) {
+    const char *pos = file->begin();
+    auto take = [&](void *record, size_t size) {
+        if ((size_t)(file->end() - pos) < size) {
+            printf("Truncated binary trace. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(record, pos, size);
+        pos += size;
+    };
+
+    TraceHeader header;
+    take(&header, sizeof(header));
+    if (header.version != 1) {
+        printf("Unsupported binary trace version %u. Exiting.\n",
+               header.version);
+        exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < header.n_processes; i++) {
+        TraceProcess record;
+        take(&record, sizeof(record));
+        Process *process = new Process();
+        process->n_vmas = record.n_vmas;
+        process->n_vpages = record.n_vpages;
+        for (uint32_t j = 0; j < record.n_areas; j++) {
+            TraceVma vma;
+            take(&vma, sizeof(vma));
+            if (vma.start > vma.end || vma.end >= PageTable::max_vpages) {
+                printf("Invalid VMA in binary trace. Exiting.\n");
+                exit(EXIT_FAILURE);
+            }
+            process->virtual_memory_areas.push_back(VirtualMemoryArea{
+                vma.start, vma.end, vma.write_protected != 0,
+                vma.file_mapped != 0});
+        }
+        processes.push_back(process);
     }
+    instructions = new BinaryInstructions(file, pos, header.n_instructions);
 }
 
 void read_input_file(const std::string &filename) {
-    std::ifstream file(filename);
-    std::string line;
-
-    // skip comments [at the beginning]
-    while (getline(file, line)) {
-        if (line.at(0) == '#') continue;
-        break;
+    MappedFile *file = new MappedFile(filename);
+    if (is_binary_trace(file->begin(), file->end())) {
+        read_binary_trace(file);
+        return;
     }
+    Scanner in(*file), line(nullptr, nullptr);
 
     // first line that is not a comment is the number of
     // processes
-    int n_processes = std::atoi(&line[0]);
+    int n_processes = 0;
+    next_input_line(in, line);
+    line.next(n_processes);
 
-    uint16_t start, end;
-    bool w_protected, f_mapped;
     for (int i = 0; i < n_processes; i++) {
-        // skip comments
-        while (getline(file, line)) {
-            if (line.at(0) == '#') continue;
-            break;
-        }
-        uint16_t n_vmas =
-            std::atoi(&line[0]);  // number of virtual memory areas
+        uint16_t n_vmas = 0;  // number of virtual memory areas
+        next_input_line(in, line);
+        line.next(n_vmas);
         std::vector<VirtualMemoryArea> vmas;
+        uint64_t n_vpages = LAB_VPAGES;
         for (int j = 0; j < n_vmas; j++) {
-            while (getline(file, line)) {
-                if (line.at(0) == '#') continue;  // Ignoring all the comments
-                std::stringstream vma;
-                vma << line;
-                vma >> start >> end >> w_protected >> f_mapped;
-                vmas.push_back(
-                    VirtualMemoryArea{start, end, w_protected, f_mapped});
-                break;
+            if (!next_input_line(in, line)) break;
+            uint64_t start = 0, end = 0;
+            int w_protected = 0, f_mapped = 0;
+            if (!(line.next(start) && line.next(end) &&
+                  line.next(w_protected) && line.next(f_mapped))) {
+                printf("Invalid VMA line. Exiting.\n");
+                exit(EXIT_FAILURE);
+            }
+            if (end >= PageTable::max_vpages) {
+                printf("VMA beyond the 48-bit address space. Exiting.\n");
+                exit(EXIT_FAILURE);
+            }
+            vmas.push_back(VirtualMemoryArea{start, end, w_protected != 0,
+                                             f_mapped != 0});
+            n_vpages = std::max(n_vpages, end + 1);
+        }
+        // an inverted VMA covers no page
+        vmas.erase(std::remove_if(vmas.begin(), vmas.end(),
+                                  [](const VirtualMemoryArea &vma) {
+                                      return vma.start > vma.end;
+                                  }),
+                   vmas.end());
+        std::sort(vmas.begin(), vmas.end(),
+                  [](const VirtualMemoryArea &a, const VirtualMemoryArea &b) {
+                      return a.start < b.start;
+                  });
+        for (size_t j = 1; j < vmas.size(); j++) {
+            if (vmas[j].start <= vmas[j - 1].end) {
+                printf("Overlapping VMAs. Exiting.\n");
+                exit(EXIT_FAILURE);
             }
         }
         // create the process
         Process *process = new Process();
         process->n_vmas = n_vmas;
+        process->n_vpages = n_vpages;
         process->virtual_memory_areas = vmas;
-        process->page_table = PageTable();
         processes.push_back(process);
     }
 
-    while (getline(file, line)) {
-        if (line.at(0) == '#') continue;  // Ignoring all the comments
+    // the instructions are decoded while the simulator runs
+    instructions = new TextInstructions(file, in);
+}
 
-        char instruction;
-        int argument;
-        std::istringstream line_stream(line);
-        line_stream >> instruction >> argument;
-        instructions.push_back(std::make_pair(instruction, argument));
+Pager *make_pager(char algorithm) {
+    switch (algorithm) {
+        case 'f':
+            return new FIFO();
+        case 'r':
+            return new Random();
+        case 'c':
+            return new Clock();
+        case 'e':
+            return new NRU();
+        case 'a':
+            return new Aging();
+        case 'w':
+            return new WorkingSet();
     }
-    n_instructions = instructions.size();
+    printf("Unknown pager '%c'. Exiting.\n", algorithm);
+    exit(EXIT_FAILURE);
 }
 
+const char *pager_name(char algorithm) {
+    switch (algorithm) {
+        case 'f':
+            return "fifo";
+        case 'r':
+            return "random";
+        case 'c':
+            return "clock";
+        case 'e':
+            return "nru";
+        case 'a':
+            return "aging";
+    }
+    return "wset";
+}
+
+// The globals one simulator works on. The pagers and the simulator use the
+// globals directly, so a lock-step run swaps each configuration's machine in
+// around its step; the containers swap by pointer.
+struct Machine {
+    uint32_t n_frames;
+    std::vector<frame_t> frame_table;
+    std::queue<uint32_t> free_frame_list;
+    std::vector<Process *> processes;
+
+    void swap_globals() {
+        std::swap(n_frames, ::n_frames);
+        frame_table.swap(::frame_table);
+        free_frame_list.swap(::free_frame_list);
+        processes.swap(::processes);
+    }
+};
+
+struct Configuration {
+    char algorithm;
+    Machine machine;
+    Simulator *simulator;
+};
+
+// Miss-ratio curve of several frame counts and pagers in one pass over the
+// instructions; a miss is a page fault that maps a page and the ratio is per
+// r/w instruction. LRU is a stack algorithm, so its misses at every frame
+// count come from the stack distances of the pass. None of the pagers is
+// one (FIFO shows Belady's anomaly, the others approximate LRU), so each
+// pager and frame count gets its own simulator. They run in lock step over
+// blocks of decoded instructions, so each configuration keeps its state in
+// cache for a whole block and the trace is still read and decoded once.
+void run_curve(const std::vector<uint32_t> &frame_counts,
+               const std::string &algorithms) {
+    std::vector<Configuration> configurations;
+    for (char algorithm : algorithms) {
+        for (uint32_t frames : frame_counts) {
+            Configuration configuration;
+            configuration.algorithm = algorithm;
+            configuration.machine.n_frames = frames;
+            for (Process *process : processes) {
+                Process *copy = new Process();
+                copy->n_vmas = process->n_vmas;
+                copy->n_vpages = process->n_vpages;
+                copy->virtual_memory_areas = process->virtual_memory_areas;
+                configuration.machine.processes.push_back(copy);
+            }
+            configurations.push_back(std::move(configuration));
+        }
+    }
+    for (Configuration &configuration : configurations) {
+        configuration.machine.swap_globals();
+        configuration.simulator =
+            new Simulator(make_pager(configuration.algorithm));
+        configuration.machine.swap_globals();
+    }
+
+    uint32_t max_frames =
+        *std::max_element(frame_counts.begin(), frame_counts.end());
+    LruStack lru;
+    std::vector<uint64_t> distances(max_frames + 2);  // last: beyond max
+    uint64_t accesses = 0;
+    int current_pid = -1;
+    auto record_lru = [&](char operation, uint64_t value) {
+        if (operation == 'c') {
+            current_pid = value;
+        } else if (operation == 'e') {
+            uint64_t pid = current_pid;
+            lru.free_pages([&](uint64_t page) { return page >> 36 == pid; });
+        } else if (operation == 'r' || operation == 'w') {
+            accesses++;
+            uint64_t page = (uint64_t)current_pid << 36 | value;
+            if (!lru.contains(page) &&
+                !processes[current_pid]->find_vma(value)) {
+                return;  // SEGV
+            }
+            uint64_t distance = lru.reference(page);
+            distances[distance == 0 ? max_frames + 1
+                                    : std::min<uint64_t>(distance,
+                                                         max_frames + 1)]++;
+        }
+    };
+
+    std::vector<std::pair<char, uint64_t> > block;
+    block.reserve(CURVE_BLOCK);
+    while (true) {
+        block.clear();
+        char operation;
+        uint64_t value;
+        while (block.size() < CURVE_BLOCK &&
+               instructions->next(operation, value)) {
+            block.push_back(std::make_pair(operation, value));
+        }
+        if (block.empty()) break;
+
+        for (Configuration &configuration : configurations) {
+            configuration.machine.swap_globals();
+            for (size_t j = 0; j < block.size(); j++) {
+                instruction_idx = n_instructions + j;
+                configuration.simulator->step(block[j].first,
+                                              block[j].second);
+            }
+            configuration.machine.swap_globals();
+        }
+        n_instructions += block.size();
+
+        for (size_t j = 0; j < block.size(); j++) {
+            record_lru(block[j].first, block[j].second);
+        }
+    }
+
+    printf("MRC %lu accesses\n", accesses);
+    printf("%8s %8s", "frames", "lru");
+    for (char algorithm : algorithms) printf(" %8s", pager_name(algorithm));
+    printf("\n");
+    for (size_t i = 0; i < frame_counts.size(); i++) {
+        uint64_t misses = 0;
+        for (uint64_t d = frame_counts[i] + 1; d <= max_frames + 1; d++) {
+            misses += distances[d];
+        }
+        printf("%8u %8.4f", frame_counts[i],
+               (double)misses / std::max<uint64_t>(accesses, 1));
+        for (size_t j = 0; j < algorithms.size(); j++) {
+            uint64_t maps = 0;
+            Configuration &configuration =
+                configurations[j * frame_counts.size() + i];
+            for (Process *process : configuration.machine.processes) {
+                maps += process->maps;
+            }
+            printf(" %8.4f", (double)maps / std::max<uint64_t>(accesses, 1));
+        }
+        printf("\n");
+    }
+}
+
+#ifndef MMU_NO_MAIN
 int main(int argc, char *argv[]) {
     int c;
-    char alg;
-    Pager *pager;
+    std::vector<uint32_t> frame_counts;
+    std::string algorithms;
     while ((c = getopt(argc, argv, "f:a:o:")) != -1) {
         switch (c) {
-            case 'f':
-                n_frames = std::atoi(optarg);
-                if (MAX_FRAMES < n_frames) {
-                    exit(0);
+            case 'f': {
+                // one frame count, or a comma-separated list for a curve
+                char *count = optarg;
+                while (true) {
+                    long frames = strtol(count, &count, 10);
+                    if (frames < 1 || frames > MAX_FRAMES) {
+                        printf(
+                            "Frame count must be between 1 and %d. "
+                            "Exiting.\n",
+                            MAX_FRAMES);
+                        exit(EXIT_FAILURE);
+                    }
+                    frame_counts.push_back(frames);
+                    if (*count != ',') break;
+                    count++;
                 }
                 break;
+            }
             case 'a':
-                alg = optarg[0];
-                switch (alg) {
-                    case 'f':
-                        pager = new FIFO();
-                        break;
-                    case 'r':
-                        pager = new Random();
-                        break;
-                    case 'c':
-                        pager = new Clock();
-                        break;
-                    case 'e':
-                        pager = new NRU();
-                        break;
-                    case 'a':
-                        pager = new Aging();
-                        break;
-                    case 'w':
-                        pager = new WorkingSet();
-                        break;
+                // one pager letter, or several for a curve
+                for (const char *letter = optarg; *letter; letter++) {
+                    if (*letter != ',') algorithms.push_back(*letter);
                 }
                 break;
             case 'o':
@@ -702,6 +1116,17 @@ int main(int argc, char *argv[]) {
     read_input_file(inputfile);
     read_random_file(randomfile);
 
-    Simulator simulator(pager);
+    // several configurations print a miss-ratio curve instead of the
+    // per-run output
+    if (frame_counts.size() > 1 || algorithms.size() > 1) {
+        O_option = P_option = F_option = S_option = false;
+        x_option = y_option = f_option = a_option = false;
+        run_curve(frame_counts, algorithms);
+        return 0;
+    }
+
+    n_frames = frame_counts.empty() ? 0 : frame_counts[0];
+    Simulator simulator(make_pager(algorithms.empty() ? 0 : algorithms[0]));
     simulator.run();
 }
+#endif
@@ -0,0 +1,129 @@
+// Packed binary MMU traces, written by trace2bin from the text input and read
+// by mmu in place of it. The file holds a TraceHeader, then per process a
+// TraceProcess followed by its VMAs as TraceVma records (sorted, without the
+// inverted ones), then the instructions.
+//
+// Each instruction starts with one byte: the opcode in the low two bits and
+// the operand in the upper six, or 63 there when the operand follows as a
+// LEB128 varint. The operand of c and e is the process id; the operand of r
+// and w is the page number minus the previous r/w page number, zigzag
+// encoded, so a trace with locality packs into about a byte per instruction.
+#ifndef MTRACE_H
+#define MTRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+struct TraceHeader {
+    char magic[4];  // "MMUB"
+    uint32_t version;
+    uint32_t n_processes;
+    uint32_t reserved;
+    uint64_t n_instructions;
+};
+
+struct TraceProcess {
+    uint32_t n_vmas;   // as given in the text input
+    uint32_t n_areas;  // TraceVma records that follow
+    uint64_t n_vpages;
+};
+
+struct TraceVma {
+    uint64_t start;
+    uint64_t end;
+    uint8_t write_protected;
+    uint8_t file_mapped;
+    uint8_t reserved[6];
+};
+
+// true if the file starts like a binary trace
+inline bool is_binary_trace(const char *begin, const char *end) {
+    return end - begin >= 4 && !memcmp(begin, "MMUB", 4);
+}
+
+// opcode of an instruction character, -1 if it has none
+inline int trace_opcode(char operation) {
+    switch (operation) {
+        case 'c':
+            return 0;
+        case 'e':
+            return 1;
+        case 'r':
+            return 2;
+        case 'w':
+            return 3;
+    }
+    return -1;
+}
+
+class TraceEncoder {
+   public:
+    // appends one instruction; its opcode must exist
+    void append(std::string &out, char operation, uint64_t value) {
+        int opcode = trace_opcode(operation);
+        uint64_t operand = value;
+        if (opcode >= 2) {
+            int64_t delta = (int64_t)(value - last_page);
+            operand = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+            last_page = value;
+        }
+        if (operand < 63) {
+            out.push_back((char)(opcode | operand << 2));
+            return;
+        }
+        out.push_back((char)(opcode | 63 << 2));
+        while (operand >= 0x80) {
+            out.push_back((char)(operand | 0x80));
+            operand >>= 7;
+        }
+        out.push_back((char)operand);
+    }
+
+   private:
+    uint64_t last_page = 0;
+};
+
+class TraceDecoder {
+   public:
+    TraceDecoder(const char *pos, const char *end) : pos(pos), end(end) {}
+
+    const char *position() const { return pos; }
+
+    // next instruction, false at the end of the range
+    bool next(char &operation, uint64_t &value) {
+        if (pos == end) return false;
+        uint8_t byte = *pos++;
+        uint64_t operand = byte >> 2;
+        if (operand == 63) operand = varint();
+        operation = "cerw"[byte & 3];
+        if ((byte & 3) >= 2) {
+            last_page += (operand >> 1) ^ -(operand & 1);
+            value = last_page;
+        } else {
+            value = operand;
+        }
+        return true;
+    }
+
+   private:
+    const char *pos;
+    const char *end;
+    uint64_t last_page = 0;
+
+    uint64_t varint() {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos == end) break;
+            uint8_t byte = *pos++;
+            result |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return result;
+        }
+        printf("Truncated binary trace. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+};
+
+#endif
@@ -0,0 +1,139 @@
+// Mattson stack distances for LRU replacement over one frame table shared by
+// all processes. LRU is a stack algorithm: with k frames the resident pages
+// are always the top k of one recency stack, so a reference misses exactly
+// for the frame counts below its distance and one pass yields the misses of
+// every frame count.
+//
+// Pages freed by a process exit leave a hole in the stack, standing for the
+// frame they free at every size that held them. The next reference that
+// misses anywhere above the topmost hole fills it instead of pushing a page
+// out, as a miss into a free frame does.
+//
+// Stack slots are numbered in reference order, so the distance of a page is
+// the number of live slots from its own to the newest, kept in a Fenwick
+// tree. Slot numbers are compacted when they run out, which keeps memory
+// proportional to the pages touched.
+#ifndef STACKDIST_H
+#define STACKDIST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class LruStack {
+   public:
+    // references a page; its stack distance (1 for the most recent page), or
+    // 0 if it is not on the stack and misses at any size
+    uint64_t reference(uint64_t page) {
+        uint64_t distance = 0;
+        auto it = slot_of.find(page);
+        if (it != slot_of.end()) {
+            uint64_t slot = it->second;
+            distance = n_live - count_before(slot);
+            if (!holes.empty() && *holes.rbegin() > slot) {
+                // a miss for the sizes between the hole and the page: it
+                // takes the free frame, and at the larger sizes the frame
+                // the page leaves is the free one
+                fill_top_hole();
+                owner[slot] = hole;
+                holes.insert(slot);
+            } else {
+                remove(slot);
+            }
+        } else if (!holes.empty()) {
+            fill_top_hole();
+        }
+        slot_of[page] = push(page);
+        return distance;
+    }
+
+    // turns the pages for which freed(page) holds into holes
+    template <typename F>
+    void free_pages(F freed) {
+        for (auto it = slot_of.begin(); it != slot_of.end();) {
+            if (freed(it->first)) {
+                owner[it->second] = hole;
+                holes.insert(it->second);
+                it = slot_of.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    bool contains(uint64_t page) const { return slot_of.count(page) != 0; }
+
+   private:
+    enum : uint64_t { empty = ~0ULL, hole = ~0ULL - 1 };  // slot owners
+
+    std::unordered_map<uint64_t, uint64_t> slot_of;
+    std::vector<uint64_t> owner;  // page of each slot, empty or hole
+    std::vector<uint64_t> tree;   // Fenwick tree of live slots
+    std::set<uint64_t> holes;
+    uint64_t n_live = 0;
+    uint64_t next_slot = 0;
+
+    uint64_t count_before(uint64_t slot) const {
+        uint64_t count = 0;
+        for (uint64_t i = slot; i > 0; i -= i & -i) count += tree[i - 1];
+        return count;
+    }
+
+    void add(uint64_t slot, int64_t delta) {
+        for (uint64_t i = slot + 1; i <= tree.size(); i += i & -i) {
+            tree[i - 1] += delta;
+        }
+    }
+
+    uint64_t push(uint64_t page) {
+        if (next_slot == owner.size()) compact();
+        owner[next_slot] = page;
+        add(next_slot, 1);
+        n_live++;
+        return next_slot++;
+    }
+
+    void remove(uint64_t slot) {
+        owner[slot] = empty;
+        add(slot, -1);
+        n_live--;
+    }
+
+    void fill_top_hole() {
+        uint64_t slot = *holes.rbegin();
+        holes.erase(slot);
+        remove(slot);
+    }
+
+    // renumbers the live slots from 0, in order, with room to grow
+    void compact() {
+        std::vector<uint64_t> live;
+        live.reserve(n_live);
+        for (uint64_t slot = 0; slot < next_slot; slot++) {
+            if (owner[slot] != empty) live.push_back(owner[slot]);
+        }
+        size_t capacity = std::max<size_t>(1024, 2 * live.size());
+        owner.assign(capacity, empty);
+        tree.assign(capacity, 0);
+        holes.clear();
+        for (uint64_t slot = 0; slot < live.size(); slot++) {
+            owner[slot] = live[slot];
+            if (live[slot] == hole) {
+                holes.insert(holes.end(), slot);
+            } else {
+                slot_of[live[slot]] = slot;
+            }
+            tree[slot] = 1;
+        }
+        // linear Fenwick build: each node passes its sum to its parent
+        for (uint64_t i = 1; i <= capacity; i++) {
+            uint64_t parent = i + (i & -i);
+            if (parent <= capacity) tree[parent - 1] += tree[i - 1];
+        }
+        next_slot = live.size();
+    }
+};
+
+#endif
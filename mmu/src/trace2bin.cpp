@@ -0,0 +1,71 @@
+// Converts an mmu input into the packed binary trace of mtrace.h, which mmu
+// reads without any text parsing:
+//
+//   make && ./trace2bin <inputfile> <binfile>
+#define MMU_NO_MAIN
+#include "mmu.cpp"
+
+bool write_trace(FILE *out) {
+    TraceHeader header = {};
+    memcpy(header.magic, "MMUB", 4);
+    header.version = 1;
+    header.n_processes = processes.size();
+    if (fwrite(&header, sizeof(header), 1, out) != 1) return false;
+
+    for (Process *process : processes) {
+        TraceProcess record = {};
+        record.n_vmas = process->n_vmas;
+        record.n_areas = process->virtual_memory_areas.size();
+        record.n_vpages = process->n_vpages;
+        if (fwrite(&record, sizeof(record), 1, out) != 1) return false;
+        for (const VirtualMemoryArea &area : process->virtual_memory_areas) {
+            TraceVma vma = {};
+            vma.start = area.start;
+            vma.end = area.end;
+            vma.write_protected = area.write_protected;
+            vma.file_mapped = area.file_mapped;
+            if (fwrite(&vma, sizeof(vma), 1, out) != 1) return false;
+        }
+    }
+
+    TraceEncoder encoder;
+    std::string buffer;
+    char operation;
+    uint64_t value;
+    while (instructions->next(operation, value)) {
+        if (trace_opcode(operation) < 0) {
+            printf("Unsupported instruction '%c'. Exiting.\n", operation);
+            exit(EXIT_FAILURE);
+        }
+        encoder.append(buffer, operation, value);
+        header.n_instructions++;
+        if (buffer.size() > (1 << 16)) {
+            if (fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+                return false;
+            }
+            buffer.clear();
+        }
+    }
+    if (fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+        return false;
+    }
+
+    // the instruction count is known only now
+    return fseek(out, 0, SEEK_SET) == 0 &&
+           fwrite(&header, sizeof(header), 1, out) == 1;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        printf("Usage: %s <inputfile> <binfile>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    read_input_file(argv[1]);
+    FILE *out = fopen(argv[2], "wb");
+    bool written = out && write_trace(out);
+    if (!out || fclose(out) != 0 || !written) {
+        printf("Cannot write %s. Exiting.\n", argv[2]);
+        exit(EXIT_FAILURE);
+    }
+}
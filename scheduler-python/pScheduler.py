@@ -3,6 +3,9 @@ from enum import Enum
 import heapq
 from collections import namedtuple
 import bisect
+import mmap
+import struct
+from typing import Sequence
 
 
 current_running_process = None
@@ -215,7 +218,16 @@ class RandGenerator:
         return rand
 
 
-def get_random_numbers(filename: str) -> list[int]:
+def get_random_numbers(filename: str) -> Sequence[int]:
+    # a precompiled rfile (common/rfile2bin) is mapped and indexed in place
+    with open(filename, "rb") as f:
+        if f.read(4) == b"RNDB":
+            table = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+            _, version, count, _ = struct.unpack_from("=4sIII", table)
+            if version != 1:
+                raise ValueError(f"unsupported random file version {version}")
+            return memoryview(table)[16 : 16 + 4 * count].cast("I")
+
     random_numbers = []
     with open(filename) as f:
         random_numbers = f.readlines()
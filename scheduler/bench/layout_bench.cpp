@@ -0,0 +1,254 @@
+// Cache benchmark for the process state layout. Replays the access pattern of
+// the simulation loop over n processes: pop the earliest event, update the
+// fields a transition touches on its process and queue the next event of that
+// process. It runs once over the previous layout (a 104-byte Process in a
+// std::deque, events holding Process pointers) and once over the ProcessTable
+// (64-byte hot records, events holding pids), and reports per event the time,
+// the cache lines of process state touched and, where perf_event_open is
+// permitted, the hardware cache misses.
+//
+//   make bench && ./layout_bench [events] [max processes]
+
+#define SCHEDULER_NO_MAIN
+#include "../src/scheduler.cpp"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+
+#include <cerrno>
+#include <chrono>
+
+// Process as it was before the hot/cold split, field for field
+struct LegacyProcess {
+    int id;
+    int at, tc, cb, io;
+    int static_prio, dynamic_prio;
+    int remaining_time, finish_time, turnaround_time, io_time, waiting_time;
+    int current_burst;
+    int cpu;
+    long vruntime;
+    int level, level_time, level_boost;
+    process_state state;
+    int current_state_start_time;
+    bool preempted;
+    uint64_t pending_seq;
+    int pending_clock;
+};
+
+struct LegacyLayout {
+    struct Ev {
+        int clock;
+        LegacyProcess* p;
+        process_transition transition;
+        uint64_t seq;
+    };
+
+    std::deque<LegacyProcess> processes;
+
+    explicit LegacyLayout(int n) {
+        for (int pid = 0; pid < n; pid++) {
+            LegacyProcess p = {};
+            p.id = pid;
+            p.cb = 10;
+            p.remaining_time = 1 << 30;
+            processes.push_back(p);
+        }
+    }
+
+    LegacyProcess* process(int pid) { return &processes[pid]; }
+    LegacyProcess* process(const Ev& e) { return e.p; }
+    Ev event(int clock, LegacyProcess* p) {
+        return Ev{clock, p, process_transition::READY_TO_RUNNING, 0};
+    }
+};
+
+struct TableLayout {
+    typedef Event Ev;
+
+    ProcessTable processes;
+
+    explicit TableLayout(int n) {
+        processes.reserve(n);
+        for (int pid = 0; pid < n; pid++) {
+            processes.add(0, 1 << 30, 10, 10, 1);
+        }
+    }
+
+    Process* process(int pid) { return processes.process(pid); }
+    Process* process(const Event& e) { return processes.process(e.pid); }
+    Event event(int clock, Process* p) {
+        return Event(clock, p, process_transition::READY_TO_RUNNING);
+    }
+};
+
+// the fields one READY -> RUNNING transition reads or writes, as the loop,
+// the event queue and the lazy cancellation check see them
+template <typename P>
+void transition(P* p, int clock) {
+    int time_in_state = clock - p->current_state_start_time;
+    if (!p->preempted) p->current_burst = std::min(p->cb, p->remaining_time);
+    p->remaining_time -= p->dynamic_prio < 0;
+    p->state = process_state::RUNNING;
+    p->current_state_start_time = clock;
+    p->waiting_time += time_in_state;
+    p->preempted = false;
+    p->cpu = 0;
+}
+
+template <typename P>
+int lines_touched(P* p) {
+    const void* fields[] = {&p->id,
+                            &p->current_state_start_time, &p->preempted,
+                            &p->current_burst,  &p->cb,
+                            &p->remaining_time, &p->dynamic_prio,
+                            &p->state,          &p->waiting_time,
+                            &p->cpu,            &p->pending_seq,
+                            &p->pending_clock};
+    std::vector<uintptr_t> lines;
+    for (auto field : fields) {
+        lines.push_back(reinterpret_cast<uintptr_t>(field) / 64);
+    }
+    std::sort(lines.begin(), lines.end());
+    return std::unique(lines.begin(), lines.end()) - lines.begin();
+}
+
+// hardware cache miss counter of this thread, or -1 if not permitted
+class CacheMissCounter {
+   public:
+    CacheMissCounter() {
+        perf_event_attr attr = {};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~CacheMissCounter() {
+        if (fd >= 0) close(fd);
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long stop() {
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+        return count;
+    }
+
+   private:
+    int fd;
+};
+
+struct Result {
+    double ns_per_event;
+    double lines_per_event;
+    double misses_per_event;  // negative without a counter
+};
+
+template <typename Layout>
+Result run(int n, long events, CacheMissCounter& counter) {
+    typedef typename Layout::Ev Ev;
+    Layout layout(n);
+    struct Later {
+        bool operator()(const Ev& a, const Ev& b) const {
+            if (a.clock != b.clock) return a.clock > b.clock;
+            return a.seq > b.seq;
+        }
+    };
+    std::vector<Ev> heap;
+    uint64_t seq = 0;
+    uint32_t rand = 2463534242u;  // xorshift32, the same stream per layout
+    auto next_rand = [&]() {
+        rand ^= rand << 13;
+        rand ^= rand >> 17;
+        rand ^= rand << 5;
+        return rand;
+    };
+    auto push = [&](int clock, int pid) {
+        auto p = layout.process(pid);
+        Ev e = layout.event(clock, p);
+        e.seq = ++seq;
+        p->pending_seq = e.seq;
+        p->pending_clock = clock;
+        heap.push_back(e);
+        std::push_heap(heap.begin(), heap.end(), Later());
+    };
+    for (int pid = 0; pid < n; pid++) {
+        push(next_rand() % n, pid);
+    }
+
+    long lines = 0;
+    for (int pid = 0; pid < n; pid++) {
+        lines += lines_touched(layout.process(pid));
+    }
+
+    counter.start();
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < events; i++) {
+        std::pop_heap(heap.begin(), heap.end(), Later());
+        Ev e = heap.back();
+        heap.pop_back();
+        auto p = layout.process(e);
+        if (e.seq != p->pending_seq) continue;
+        p->pending_seq = 0;
+        transition(p, e.clock);
+        push(e.clock + 1 + next_rand() % n, p->id);
+    }
+    auto end = std::chrono::steady_clock::now();
+    long misses = counter.stop();
+
+    Result result;
+    result.ns_per_event =
+        std::chrono::duration<double, std::nano>(end - start).count() / events;
+    result.lines_per_event = (double)lines / n;
+    result.misses_per_event = misses < 0 ? -1 : (double)misses / events;
+    return result;
+}
+
+void print_misses(double misses) {
+    if (misses < 0) {
+        printf(" %9s", "-");
+    } else {
+        printf(" %9.2f", misses);
+    }
+}
+
+int main(int argc, char** argv) {
+    long events = argc > 1 ? atol(argv[1]) : 2000000;
+    int max_processes = argc > 2 ? atoi(argv[2]) : 5000000;
+
+    CacheMissCounter counter;
+    printf("process bytes: %zu legacy, %zu table; event bytes: %zu legacy, "
+           "%zu table\n",
+           sizeof(LegacyProcess), sizeof(Process),
+           sizeof(LegacyLayout::Ev), sizeof(Event));
+    if (!counter.available()) {
+        printf("no hardware cache counter (perf_event_open: %s)\n",
+               strerror(errno));
+    }
+    printf("%10s | %9s %9s %9s | %9s %9s %9s\n", "processes", "ns/event",
+           "lines", "misses", "ns/event", "lines", "misses");
+    printf("%10s | %29s | %29s\n", "", "legacy (deque, pointers)",
+           "ProcessTable (pids)");
+    for (int n = 1000; n <= max_processes; n *= 4) {
+        Result legacy = run<LegacyLayout>(n, events, counter);
+        Result table = run<TableLayout>(n, events, counter);
+        printf("%10d | %9.1f %9.2f", n, legacy.ns_per_event,
+               legacy.lines_per_event);
+        print_misses(legacy.misses_per_event);
+        printf(" | %9.1f %9.2f", table.ns_per_event, table.lines_per_event);
+        print_misses(table.misses_per_event);
+        printf("\n");
+    }
+}
@@ -0,0 +1,109 @@
+// Startup micro-benchmark: loads the random file and the process input with
+// the previous iostream code and with the mmap + hand-written parser, checks
+// that both give the same numbers and reports the time per load.
+//
+//   make bench && ./parse_bench <inputfile> <randomfile> [repeats]
+
+#define SCHEDULER_NO_MAIN
+#include "../src/scheduler.cpp"
+
+#include <chrono>
+#include <fstream>
+
+std::vector<int> iostream_random_numbers(const std::string& filename) {
+    std::ifstream infile(filename);
+    int number;
+    infile >> number;
+    std::vector<int> random_numbers;
+    random_numbers.reserve(number);
+    while (infile >> number) {
+        random_numbers.push_back(number);
+    }
+    return random_numbers;
+}
+
+std::vector<ProcessInput> iostream_process_inputs(const std::string& filename) {
+    int at, tc, cb, io;
+    std::ifstream infile(filename);
+    std::string line;
+    std::vector<ProcessInput> inputs;
+    while (std::getline(infile, line)) {
+        std::istringstream iss(line);
+        iss >> at >> tc >> cb >> io;
+        inputs.push_back(ProcessInput{at, tc, cb, io});
+    }
+    return inputs;
+}
+
+template <typename F>
+double time_ms(F load, int repeats) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; i++) {
+        load();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() /
+           repeats;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <inputfile> <randomfile> [repeats]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    std::string inputfile = argv[1];
+    std::string randomfile = argv[2];
+    int repeats = argc > 3 ? atoi(argv[3]) : 20;
+
+    // same values from both paths, compared through the generator's draws
+    auto reference = iostream_random_numbers(randomfile);
+    RandGenerator rand_generator(randomfile);
+    for (size_t i = 0; i < reference.size(); i++) {
+        if (rand_generator.next(1 << 30) != 1 + reference[i] % (1 << 30)) {
+            printf("random numbers differ at %zu\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    auto reference_inputs = iostream_process_inputs(inputfile);
+    auto inputs = read_process_inputs(inputfile);
+    if (inputs.size() != reference_inputs.size() ||
+        !std::equal(inputs.begin(), inputs.end(), reference_inputs.begin(),
+                    [](const ProcessInput& a, const ProcessInput& b) {
+                        return a.at == b.at && a.tc == b.tc && a.cb == b.cb &&
+                               a.io == b.io;
+                    })) {
+        printf("process inputs differ\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double rand_iostream =
+        time_ms([&]() { iostream_random_numbers(randomfile); }, repeats);
+    double rand_fast = time_ms([&]() { RandGenerator r(randomfile); }, repeats);
+
+    // the same table precompiled, which is mapped instead of parsed
+    char binfile[] = "/tmp/parse_bench_rfile_XXXXXX";
+    close(mkstemp(binfile));
+    RandomTable(randomfile).save(binfile);
+    RandGenerator bin_generator(binfile);
+    for (size_t i = 0; i < reference.size(); i++) {
+        if (bin_generator.next(1 << 30) != 1 + reference[i] % (1 << 30)) {
+            printf("precompiled random numbers differ at %zu\n", i);
+            exit(EXIT_FAILURE);
+        }
+    }
+    double rand_bin = time_ms([&]() { RandGenerator r(binfile); }, repeats);
+    unlink(binfile);
+    double input_iostream =
+        time_ms([&]() { iostream_process_inputs(inputfile); }, repeats);
+    double input_fast =
+        time_ms([&]() { read_process_inputs(inputfile); }, repeats);
+
+    printf("%-12s %10s %12s %12s\n", "file", "values", "iostream ms",
+           "fast ms");
+    printf("%-12s %10zu %12.3f %12.3f\n", "random", reference.size(),
+           rand_iostream, rand_fast);
+    printf("%-12s %10zu %12s %12.3f\n", "random.bin", reference.size(), "-",
+           rand_bin);
+    printf("%-12s %10zu %12.3f %12.3f\n", "input", 4 * inputs.size(),
+           input_iostream, input_fast);
+}
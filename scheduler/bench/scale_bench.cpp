@@ -0,0 +1,133 @@
+// Scaling benchmark: generates workloads of 10, 100, ... processes (see
+// src/workgen.h) and simulates each with every scheduling policy. Every run
+// happens in a child process, so its peak RSS is its own; the loop itself is
+// timed and its events, one per transition, are counted through a tracer.
+// Arrivals are tuned so one CPU is about 90% busy and the clock stays within
+// an int up to 10^8 processes.
+//
+//   make bench && ./scale_bench <randomfile> [max processes]
+//                               [poisson|bursty|diurnal]
+
+#define SCHEDULER_NO_MAIN
+#include "../src/scheduler.cpp"
+#include "../src/workgen.h"
+
+#include <sys/wait.h>
+
+#include <chrono>
+
+struct CountingTracer {
+    long n_events = 0;
+
+    void record(const TraceRecord&) { n_events++; }
+};
+
+struct RunResult {
+    long n_events;
+    double loop_seconds;
+};
+
+// the scheduler's default path: parse the whole input, then simulate
+RunResult run_policy(const std::string& spec, const std::string& inputfile,
+                     const std::string& randomfile) {
+    RandGenerator rand_generator(randomfile);
+    std::vector<CPU> cpus(1, CPU(make_scheduler(spec, &rand_generator)));
+    ProcessTable processes;
+    create_processes(read_process_inputs(inputfile), &rand_generator,
+                     cpus[0].scheduler->maxprio, &processes);
+    EventQueue* event_queue = make_event_queue('h');
+    DES des(&processes, event_queue);
+
+    CountingTracer tracer;
+    auto start = std::chrono::steady_clock::now();
+    policy_loop(spec, &des, cpus, LoadBalancer(), &rand_generator, tracer,
+                nullptr);
+    auto end = std::chrono::steady_clock::now();
+    return RunResult{tracer.n_events,
+                     std::chrono::duration<double>(end - start).count()};
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <randomfile> [max processes] "
+               "[poisson|bursty|diurnal]\n",
+               argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    std::string randomfile = argv[1];
+    long max_processes = argc > 2 ? atol(argv[2]) : 1000000;
+
+    GeneratorOptions options;
+    options.tc_max = 20;
+    options.cb_max = 10;
+    options.io_max = 20;
+    options.mean_interarrival = 11.7;  // mean tc 10.5 at 90% utilization
+    options.period = 10000;
+    std::string pattern = argc > 3 ? argv[3] : "poisson";
+    if (pattern == "bursty") {
+        options.arrivals = arrival_pattern::BURSTY;
+    } else if (pattern == "diurnal") {
+        options.arrivals = arrival_pattern::DIURNAL;
+    } else if (pattern != "poisson") {
+        printf("Invalid arrival pattern provided. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const char* specs[] = {"F", "L", "S", "R10", "P10", "E10",
+                           "C", "M10", "T10", "W10"};
+
+    char inputfile[] = "/tmp/scale_bench_XXXXXX";
+    int fd = mkstemp(inputfile);
+    if (fd < 0) {
+        printf("Cannot create a workload file. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+    close(fd);
+
+    printf("%s arrivals\n", pattern.c_str());
+    printf("%10s %8s %12s %10s %14s %10s\n", "processes", "sched", "events",
+           "loop s", "events/s", "peak MB");
+    for (long n = 10; n <= max_processes; n *= 10) {
+        FILE* out = fopen(inputfile, "w");
+        bool written = out && write_workload(options, n, out);
+        if (!out || fclose(out) != 0 || !written) {
+            printf("Cannot write the workload file. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (const char* spec : specs) {
+            int result_pipe[2];
+            if (pipe(result_pipe) != 0) {
+                printf("Cannot create a pipe. Exiting.\n");
+                exit(EXIT_FAILURE);
+            }
+            fflush(stdout);
+            pid_t child = fork();
+            if (child == 0) {
+                close(result_pipe[0]);
+                RunResult result = run_policy(spec, inputfile, randomfile);
+                ssize_t n_written =
+                    write(result_pipe[1], &result, sizeof(result));
+                _exit(n_written == sizeof(result) ? 0 : 1);
+            }
+            close(result_pipe[1]);
+            RunResult result;
+            bool received =
+                read(result_pipe[0], &result, sizeof(result)) ==
+                sizeof(result);
+            close(result_pipe[0]);
+            int status;
+            struct rusage usage;
+            wait4(child, &status, 0, &usage);
+            if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                printf("%10ld %8s %12s\n", n, spec, "failed");
+                continue;
+            }
+            printf("%10ld %8s %12ld %10.3f %14.0f %10.1f\n", n, spec,
+                   result.n_events, result.loop_seconds,
+                   result.n_events / std::max(result.loop_seconds, 1e-9),
+                   usage.ru_maxrss / 1024.0);
+        }
+    }
+    unlink(inputfile);
+}
@@ -0,0 +1,65 @@
+// Stress benchmark for the SRTF ready queue: measures the cost of one
+// dispatch + re-add cycle as the number of ready processes grows.
+//
+//   make bench && ./srtf_bench [cycles]
+
+#define SCHEDULER_NO_MAIN
+#include "../src/scheduler.cpp"
+
+#include <chrono>
+#include <random>
+
+// the previous list-based SRTF, kept as a reference point
+class ListSRTF : public Scheduler {
+   public:
+    Process* get_next_process() {
+        if (runQ.empty()) return nullptr;
+        auto shortest_process = std::min_element(
+            runQ.begin(), runQ.end(), [](const Process* p1, const Process* p2) {
+                return p1->remaining_time < p2->remaining_time;
+            });
+        Process* p = *shortest_process;
+        runQ.erase(shortest_process);
+        return p;
+    }
+};
+
+// ns per get_next_process + add_process with `n_ready` processes queued
+double time_dispatch(Scheduler* scheduler, int n_ready, int cycles) {
+    std::mt19937 rng(42);
+    ProcessTable processes;
+    processes.reserve(n_ready);
+    for (int i = 0; i < n_ready; i++) {
+        scheduler->add_process(processes.add(0, 1 + rng() % 10000, 10, 10, 1));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < cycles; i++) {
+        Process* p = scheduler->get_next_process();
+        // model a partially consumed burst before the process is ready again
+        p->remaining_time += 1 + rng() % 100;
+        scheduler->add_process(p);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           cycles;
+}
+
+int main(int argc, char** argv) {
+    int cycles = argc > 1 ? atoi(argv[1]) : 200000;
+
+    printf("%10s %14s %14s\n", "ready", "SRTF ns/op", "list ns/op");
+    for (int n_ready = 10; n_ready <= 1000000; n_ready *= 10) {
+        SRTF srtf;
+        double heap_ns = time_dispatch(&srtf, n_ready, cycles);
+
+        // the linear scan gets too slow to sample past 10^4 ready processes
+        if (n_ready <= 10000) {
+            ListSRTF list_srtf;
+            double list_ns = time_dispatch(&list_srtf, n_ready, cycles / 10);
+            printf("%10d %14.1f %14.1f\n", n_ready, heap_ns, list_ns);
+        } else {
+            printf("%10d %14.1f %14s\n", n_ready, heap_ns, "-");
+        }
+    }
+}
@@ -1,160 +1,670 @@
+#include <sys/resource.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdint>
 #include <cstdio>
-// #include <cstring>
-#include <fstream>
+#include <cstring>
+#include <iterator>
 #include <list>
+#include <memory>
+#include <new>
+#include <queue>
+#include <set>
 #include <sstream>
+#include <thread>
+#include <type_traits>
 // #include <string>
 #include <vector>
 
-int verbose_mode = 0;
+#include "../../common/fastio.h"
+#include "../../common/randtable.h"
+#include "trace.h"
 
-enum class process_transition {
-    CREATED_TO_READY,
-    READY_TO_RUNNING,
-    RUNNING_TO_BLOCKED,
-    BLOCKED_TO_READY,
-    RUNNING_TO_READY,
-    RUNNING_TO_DONE
-};
+int verbose_mode = 0;
 
-enum class process_state { CREATED, READY, RUNNING, BLOCKED, DONE };
+enum class process_state : uint8_t { CREATED, READY, RUNNING, BLOCKED, DONE };
 
-class Process {
+// The per-process state the event loop reads and writes on every transition,
+// packed into one cache line. What is only needed at arrival, completion and
+// in the summary lives in the cold arrays of the ProcessTable.
+class alignas(64) Process {
    public:
-    int id;
-    int at, tc, cb, io;
-    int static_prio, dynamic_prio;
-    int remaining_time, finish_time, turnaround_time, io_time, waiting_time;
-    int current_burst;
-
+    // handle of the single queued event of this process, seq 0 if none
+    uint64_t pending_seq;
+    // policy state; a process is under one policy at a time, so they overlap
+    union {
+        long vruntime;  // weighted CPU time: CFS vruntime, stride pass
+        struct {
+            // MLFQ: ticks used at the current level and 1 + the boost
+            // period the level was set in, 0 before the first one
+            int32_t level_time, level_boost;
+        };
+    };
+    int32_t id;
+    int32_t cb, io;
+    int32_t remaining_time, current_burst;
+    int32_t current_state_start_time;
+    int32_t waiting_time, io_time;
+    int32_t pending_clock;
+    int16_t static_prio, dynamic_prio;
+    int16_t cpu;    // CPU whose run queue the process is on or last ran on
+    int16_t level;  // MLFQ queue level
     process_state state;
-    int current_state_start_time;
     bool preempted;
 
     Process(int id, int at, int tc, int cb, int io, int static_prio)
-        : id(id),
-          at(at),
-          tc(tc),
+        : pending_seq(0),
+          vruntime(0),
+          id(id),
           cb(cb),
           io(io),
-          static_prio(static_prio),
-          dynamic_prio(static_prio - 1),
           remaining_time(tc),
-          finish_time(-1),
-          turnaround_time(-1),
-          io_time(0),
-          waiting_time(0),
           current_burst(-1),
-          state(process_state::CREATED),
           current_state_start_time(at),
+          waiting_time(0),
+          io_time(0),
+          pending_clock(-1),
+          static_prio(static_prio),
+          dynamic_prio(static_prio - 1),
+          cpu(0),
+          level(0),
+          state(process_state::CREATED),
           preempted(false) {}
+
+    // forgets what the previous scheduling policy kept on the process, for a
+    // run resumed from a checkpoint under another policy
+    void reset_policy_state() {
+        dynamic_prio = static_prio - 1;
+        vruntime = 0;
+        level = 0;
+    }
 };
 
+static_assert(sizeof(Process) == 64, "Process is one cache line");
+
+// A cursor over the random file, text or precompiled. Copies share the
+// read-only table and only carry their own rand_index, so concurrent runs can
+// each hold one.
 class RandGenerator {
    private:
-    std::vector<int> random_numbers;
+    std::shared_ptr<const RandomTable> random_numbers;
 
    public:
     int rand_index = 0;
-    RandGenerator(const std::string& filename) {
-        std::ifstream infile(filename);
-        int number;
-        infile >> number;  // first number is the number of random numbers
-        random_numbers.reserve(number);
-        while (infile >> number) {
-            random_numbers.push_back(number);
-        }
+    RandGenerator(const std::string& filename)
+        : random_numbers(std::make_shared<const RandomTable>(filename)) {}
+
+    void reset() { rand_index = 0; }
+
+    // advance as if next() had been called n times
+    void skip(size_t n) {
+        rand_index = (rand_index + n) % random_numbers->size();
     }
 
     int next(int value) {
-        int rand = 1 + (random_numbers[rand_index] % value);
-        rand_index = (rand_index + 1) % random_numbers.size();
+        int rand = 1 + ((*random_numbers)[rand_index] % value);
+        rand_index = (rand_index + 1) % random_numbers->size();
         return rand;
     }
 };
 
+// refers to its process by pid, so an event is 16 bytes
 struct Event {
     int clock;
-    Process* p;
-    process_transition transition;
+    int pid;
+    uint64_t seq : 56;  // insertion order, breaks ties between equal clocks
+    process_transition transition : 8;
 
     Event(int clock, Process* p, process_transition transition)
-        : clock(clock), p(p), transition(transition) {}
+        : clock(clock), pid(p->id), seq(0), transition(transition) {}
 };
 
-class DES {
+static_assert(sizeof(Event) == 16, "Event is 16 bytes");
+
+// strict ordering used by every backend: earlier clock first, and for equal
+// clocks the event that was added first (FIFO)
+inline bool event_before(const Event& a, const Event& b) {
+    if (a.clock != b.clock) return a.clock < b.clock;
+    return a.seq < b.seq;
+}
+
+// Backends for the DES event queue. Events are stored by value and storage is
+// reused, so a steady-state simulation does not allocate per event. Cancelled
+// events are left in place and dropped by the DES when they reach the front.
+class EventQueue {
    public:
-    std::vector<Process*> process_array;
-    std::list<Event*> eventQ;
-    int total_io_time = 0;
+    std::string name;
+    virtual ~EventQueue() {}
+    virtual void push(const Event& e) = 0;
+    virtual Event pop() = 0;
+    virtual const Event* top() = 0;
+    virtual bool empty() = 0;
+};
 
-    DES(std::vector<Process*> process_array) {
-        this->process_array = process_array;
-        for (auto p : process_array) {
-            add_event(
-                new Event(p->at, p, process_transition::CREATED_TO_READY));
+// sorted linked list, O(n) insert
+class ListEventQueue : public EventQueue {
+   public:
+    std::list<Event> eventQ;
+    std::list<Event> spare;  // nodes of popped events, reused by push
+
+    ListEventQueue() { name = "list"; }
+
+    void push(const Event& e) {
+        auto it = eventQ.begin();
+        while (it != eventQ.end()) {
+            if (it->clock > e.clock) break;
+            it++;
+        }
+        if (spare.empty()) {
+            eventQ.insert(it, e);
+        } else {
+            spare.front() = e;
+            eventQ.splice(it, spare, spare.begin());
         }
     }
 
-    void add_event(Event* e) {
-        if (eventQ.empty()) {
-            eventQ.push_back(e);
-            return;
+    Event pop() {
+        Event e = eventQ.front();
+        spare.splice(spare.begin(), eventQ, eventQ.begin());
+        return e;
+    }
+
+    const Event* top() { return eventQ.empty() ? nullptr : &eventQ.front(); }
+
+    bool empty() { return eventQ.empty(); }
+};
+
+// binary min-heap, O(log n) push/pop
+class HeapEventQueue : public EventQueue {
+   public:
+    std::vector<Event> heap;
+
+    HeapEventQueue() { name = "heap"; }
+
+    void push(const Event& e) {
+        heap.push_back(e);
+        sift_up(heap.size() - 1);
+    }
+
+    Event pop() {
+        Event e = heap.front();
+        heap.front() = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) sift_down(0);
+        return e;
+    }
+
+    const Event* top() { return heap.empty() ? nullptr : &heap.front(); }
+
+    bool empty() { return heap.empty(); }
+
+   private:
+    void sift_up(size_t i) {
+        Event e = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!event_before(e, heap[parent])) break;
+            heap[i] = heap[parent];
+            i = parent;
         }
+        heap[i] = e;
+    }
 
-        auto it = eventQ.begin();
-        while (it != eventQ.end()) {
-            if ((*it)->clock > e->clock) {
-                eventQ.insert(it, e);
-                return;
+    void sift_down(size_t i) {
+        Event e = heap[i];
+        size_t n = heap.size();
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= n) break;
+            if (child + 1 < n && event_before(heap[child + 1], heap[child])) {
+                child++;
             }
-            it++;
+            if (!event_before(heap[child], e)) break;
+            heap[i] = heap[child];
+            i = child;
         }
-        eventQ.push_back(e);
+        heap[i] = e;
+    }
+};
+
+// calendar queue (R. Brown, CACM 1988): an array of day buckets, each
+// covering `width` ticks, that wraps around like a year. Enqueue and dequeue
+// are O(1) on average when many events share nearby timestamps.
+class CalendarEventQueue : public EventQueue {
+   public:
+    // sorted events of one day; popped events are skipped via `head` and the
+    // vector is compacted lazily so its capacity is reused
+    struct Bucket {
+        std::vector<Event> events;
+        size_t head = 0;
+
+        bool empty() const { return head == events.size(); }
+        Event& front() { return events[head]; }
+    };
+
+    std::vector<Bucket> buckets;
+    int width = 1;
+    size_t n_events = 0;
+    size_t cur_bucket = 0;  // bucket holding the current position
+    long bucket_top = 1;    // first clock past the current bucket's day
+
+    CalendarEventQueue() {
+        name = "calendar";
+        buckets.resize(2);
     }
 
-    Event next_event() {
-        Event e = *eventQ.front();
-        eventQ.pop_front();
+    void push(const Event& e) {
+        if (e.clock < bucket_top - width) {
+            // earlier than the current day, move the calendar back
+            cur_bucket = bucket_index(e.clock);
+            bucket_top = ((long)e.clock / width + 1) * width;
+        }
+        insert(e);
+        n_events++;
+        if (n_events > 2 * buckets.size()) resize(2 * buckets.size());
+    }
+
+    Event pop() {
+        top();
+        Bucket& b = buckets[cur_bucket];
+        Event e = b.front();
+        b.head++;
+        if (b.empty()) {
+            b.events.clear();
+            b.head = 0;
+        }
+        n_events--;
+        if (buckets.size() > 2 && n_events < buckets.size() / 2) {
+            resize(buckets.size() / 2);
+        }
         return e;
     }
 
-    void delete_event(Process* p) {
-        auto it = eventQ.begin();
-        while (it != eventQ.end()) {
-            if ((*it)->p == p) {
-                eventQ.erase(it);
-                return;
+    const Event* top() {
+        if (n_events == 0) return nullptr;
+        size_t i = cur_bucket;
+        long top = bucket_top;
+        for (size_t k = 0; k < buckets.size(); k++) {
+            Bucket& b = buckets[i];
+            if (!b.empty() && b.front().clock < top) {
+                cur_bucket = i;
+                bucket_top = top;
+                return &b.front();
             }
-            it++;
+            i = (i + 1) % buckets.size();
+            top += width;
+        }
+
+        // nothing within a year of the current position, jump directly to
+        // the earliest event
+        Event* best = nullptr;
+        for (auto& b : buckets) {
+            if (!b.empty() && (!best || event_before(b.front(), *best))) {
+                best = &b.front();
+            }
+        }
+        cur_bucket = bucket_index(best->clock);
+        bucket_top = ((long)best->clock / width + 1) * width;
+        return best;
+    }
+
+    bool empty() { return n_events == 0; }
+
+   private:
+    size_t bucket_index(int clock) {
+        return ((size_t)clock / width) % buckets.size();
+    }
+
+    // keep each bucket sorted, equal clocks in FIFO order
+    void insert(const Event& e) {
+        Bucket& b = buckets[bucket_index(e.clock)];
+        if (b.head > 0 && b.head * 2 >= b.events.size()) {
+            b.events.erase(b.events.begin(), b.events.begin() + b.head);
+            b.head = 0;
+        }
+        size_t i = b.events.size();
+        while (i > b.head && event_before(e, b.events[i - 1])) i--;
+        b.events.insert(b.events.begin() + i, e);
+    }
+
+    // rebuild with a new bucket count, picking the day width from the
+    // average spacing of the earliest events
+    void resize(size_t n_buckets) {
+        std::vector<Event> all;
+        all.reserve(n_events);
+        for (auto& b : buckets) {
+            all.insert(all.end(), b.events.begin() + b.head, b.events.end());
+        }
+        std::sort(all.begin(), all.end(), event_before);
+
+        size_t n_sample = std::min<size_t>(all.size(), 25);
+        if (n_sample > 1) {
+            long span = all[n_sample - 1].clock - all[0].clock;
+            width = std::max<long>(1, 3 * span / (long)(n_sample - 1));
+        }
+
+        buckets.assign(n_buckets, Bucket());
+        for (auto& e : all) buckets[bucket_index(e.clock)].events.push_back(e);
+        if (!all.empty()) {
+            cur_bucket = bucket_index(all[0].clock);
+            bucket_top = ((long)all[0].clock / width + 1) * width;
+        }
+    }
+};
+
+EventQueue* make_event_queue(char kind) {
+    switch (kind) {
+        case 'l':
+            return new ListEventQueue();
+        case 'h':
+            return new HeapEventQueue();
+        case 'c':
+            return new CalendarEventQueue();
+    }
+    return nullptr;
+}
+
+// All processes of one run, indexed by pid. The hot records form one cache
+// line aligned array and the cold fields are parallel arrays, one per field.
+// The capacity is fixed before the first process is added, so the Process
+// pointers held by the run queues stay valid.
+class ProcessTable {
+   public:
+    std::vector<int> at, tc, finish_time, turnaround_time;
+
+    ProcessTable() {}
+    ~ProcessTable() { free(hot); }
+
+    ProcessTable(const ProcessTable&) = delete;
+    ProcessTable& operator=(const ProcessTable&) = delete;
+
+    // new ignores alignas(64) before C++17, hence posix_memalign
+    void reserve(size_t n) {
+        void* memory = nullptr;
+        if (hot || posix_memalign(&memory, alignof(Process),
+                                  std::max<size_t>(n, 1) * sizeof(Process))) {
+            printf("Cannot allocate the process table. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+        hot = static_cast<Process*>(memory);
+        capacity = n;
+        at.reserve(n);
+        tc.reserve(n);
+        finish_time.reserve(n);
+        turnaround_time.reserve(n);
+    }
+
+    Process* add(int at, int tc, int cb, int io, int static_prio) {
+        if (n_processes == capacity) {
+            printf("Process table is full. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+        int pid = n_processes++;
+        this->at.push_back(at);
+        this->tc.push_back(tc);
+        finish_time.push_back(-1);
+        turnaround_time.push_back(-1);
+        return new (&hot[pid]) Process(pid, at, tc, cb, io, static_prio);
+    }
+
+    size_t size() const { return n_processes; }
+    Process* process(int pid) const { return &hot[pid]; }
+
+   private:
+    Process* hot = nullptr;
+    size_t capacity = 0;
+    size_t n_processes = 0;
+};
+
+// number of lines std::getline would return for the file
+size_t count_lines(const std::string& filename) {
+    MappedFile file(filename);
+    size_t n_lines = std::count(file.begin(), file.end(), '\n');
+    if (file.begin() != file.end() && file.end()[-1] != '\n') n_lines++;
+    return n_lines;
+}
+
+// Reads an arrival-sorted input file one process at a time, so only the next
+// arrival exists before simulated time reaches it. Static priorities are drawn
+// from their own cursor, which starts where a fully parsed run starts.
+class ProcessStream {
+   public:
+    ProcessStream(const std::string& filename, RandGenerator prio_generator,
+                  int maxprio, ProcessTable* processes)
+        : file(filename),
+          in(file),
+          prio_generator(prio_generator),
+          maxprio(maxprio),
+          processes(processes) {
+        this->prio_generator.reset();
+        advance();
+    }
+
+    Process* peek() { return next_process; }
+    int peek_at() { return next_at; }
+
+    Process* pop() {
+        Process* p = next_process;
+        advance();
+        return p;
+    }
+
+   private:
+    MappedFile file;
+    Scanner in;
+    RandGenerator prio_generator;
+    int maxprio;
+    ProcessTable* processes;
+    Process* next_process = nullptr;
+    int next_at = 0;
+
+    void advance() {
+        Scanner line(nullptr, nullptr);
+        if (!in.next_line(line)) {
+            next_process = nullptr;
+            return;
+        }
+        int at = 0, tc = 0, cb = 0, io = 0;
+        line.next(at) && line.next(tc) && line.next(cb) && line.next(io);
+        if (processes->size() > 0 && at < next_at) {
+            printf("Streamed input is not sorted by arrival time. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        int sprio = prio_generator.next(maxprio);
+        next_process = processes->add(at, tc, cb, io, sprio);
+        next_at = at;
+    }
+};
+
+// Log-linear histogram in the style of HdrHistogram: values below 128 get a
+// bucket each, and every power of two above that is split into 64 buckets, so
+// a reported value is within 1/64 of the recorded one. Recording is a count
+// of leading zeros and an increment.
+class LatencyHistogram {
+   public:
+    static const int sub_bits = 7;
+    static const int half = 1 << (sub_bits - 1);
+
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    long max_value = 0;
+
+    LatencyHistogram() : counts((64 - sub_bits + 2) * half) {}
+
+    static int bucket(unsigned long v) {
+        if (v < 2 * half) return v;
+        int shift = 63 - __builtin_clzll(v) - (sub_bits - 1);
+        return shift * half + (v >> shift);
+    }
+
+    // largest value that lands in bucket i
+    static long bucket_top(int i) {
+        if (i < 2 * half) return i;
+        int shift = i / half - 1;
+        long top = i % half + half;
+        return ((top + 1) << shift) - 1;
+    }
+
+    void record(long v) {
+        if (v < 0) v = 0;
+        counts[bucket(v)]++;
+        total++;
+        max_value = std::max(max_value, v);
+    }
+
+    // value at or below which `percent` of the recorded values lie
+    long percentile(double percent) const {
+        if (total == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, ceil(percent / 100 * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); i++) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucket_top(i), max_value);
+        }
+        return max_value;
+    }
+};
+
+// Wait time is recorded for every READY -> RUNNING dispatch, response time
+// (arrival to first dispatch) once per process. Waits are also kept per
+// dynamic priority of the dispatched process.
+struct LatencyStats {
+    LatencyHistogram wait, response;
+    std::vector<LatencyHistogram> wait_by_prio;
+
+    void record_dispatch(Process* p, int waited) {
+        wait.record(waited);
+        if (p->dynamic_prio >= 0) {
+            if ((size_t)p->dynamic_prio >= wait_by_prio.size()) {
+                wait_by_prio.resize(p->dynamic_prio + 1);
+            }
+            wait_by_prio[p->dynamic_prio].record(waited);
+        }
+    }
+};
+
+class DES {
+   public:
+    ProcessTable* processes;
+    EventQueue* eventQ;
+    ProcessStream* arrivals = nullptr;
+    uint64_t n_added = 0;
+    int total_io_time = 0;
+    std::vector<long> cpu_busy_time;  // per simulated CPU
+    long n_migrations = 0;
+    LatencyStats latency;
+    // loop state that outlives a single event, kept here for checkpoints
+    int n_io_blocked = 0;
+    int io_start_time = 0;
+    int next_balance = 0;  // clock of the next periodic rebalance
+
+    // queues the arrival of every process in the table; restore_checkpoint
+    // fills a DES built over an empty table
+    DES(ProcessTable* processes, EventQueue* eventQ)
+        : processes(processes), eventQ(eventQ) {
+        for (size_t pid = 0; pid < processes->size(); pid++) {
+            add_event(Event(processes->at[pid], processes->process(pid),
+                            process_transition::CREATED_TO_READY));
+        }
+    }
+
+    // Arrivals are pulled from the stream, which adds them to the table, as
+    // time advances instead of being queued up front. A queued run adds every
+    // CREATED_TO_READY event first, so on equal clocks the next arrival goes
+    // before any queued event.
+    DES(ProcessStream* arrivals, ProcessTable* processes, EventQueue* eventQ)
+        : processes(processes), eventQ(eventQ), arrivals(arrivals) {}
+
+    Process* process(const Event& e) const {
+        return processes->process(e.pid);
+    }
+
+    void add_event(Event e) {
+        e.seq = ++n_added;
+        Process* p = process(e);
+        p->pending_seq = e.seq;
+        p->pending_clock = e.clock;
+        eventQ->push(e);
+    }
+
+    Event next_event() {
+        drop_cancelled();
+        if (arrival_due()) {
+            int at = arrivals->peek_at();
+            return Event(at, arrivals->pop(),
+                         process_transition::CREATED_TO_READY);
         }
+        Event e = eventQ->pop();
+        process(e)->pending_seq = 0;
+        return e;
     }
 
+    // O(1): the event is only forgotten here and skipped once it surfaces
+    void delete_event(Process* p) { p->pending_seq = 0; }
+
     int next_event_time() {
-        if (!eventQ.empty()) {
-            return eventQ.front()->clock;
+        drop_cancelled();
+        if (arrival_due()) {
+            return arrivals->peek_at();
         }
-        return -1;
+        const Event* e = eventQ->top();
+        return e ? e->clock : -1;
     }
 
     int next_event_time_for_proc(Process* p) {
-        auto it = eventQ.begin();
-        while (it != eventQ.end()) {
-            if ((*it)->p == p) {
-                return (*it)->clock;
-            }
-            it++;
+        return p->pending_seq ? p->pending_clock : -1;
+    }
+    bool empty() {
+        drop_cancelled();
+        return eventQ->empty() && !(arrivals && arrivals->peek());
+    }
+
+    // live events in firing order; the queue keeps them, minus the
+    // cancelled ones
+    std::vector<Event> pending_events() {
+        std::vector<Event> events;
+        while (!eventQ->empty()) {
+            Event e = eventQ->pop();
+            if (e.seq == process(e)->pending_seq) events.push_back(e);
         }
-        return -1;
+        for (auto& e : events) eventQ->push(e);
+        return events;
     }
-    bool empty() { return eventQ.empty(); }
+
+   private:
+    bool arrival_due() {
+        if (!arrivals || !arrivals->peek()) return false;
+        const Event* e = eventQ->top();
+        return !e || arrivals->peek_at() <= e->clock;
+    }
+
+    void drop_cancelled() {
+        const Event* e;
+        while ((e = eventQ->top()) && e->seq != process(*e)->pending_seq) {
+            eventQ->pop();
+        }
+    }
+};
+
+// Ready processes in the order a scheduler keeps them, each tagged with the
+// internal queue it is on, plus the counters the policy carries between
+// dispatches. A checkpoint stores this so the same policy can pick up exactly
+// where it stopped.
+struct SchedulerState {
+    std::vector<std::pair<Process*, int>> queued;
+    std::vector<long> counters;
 };
 
 class Scheduler {
    public:
+    // whether a process becoming ready may preempt the running one
+    static const bool preemptive = false;
+
     std::string name;
     int quantum;
     int maxprio;
@@ -166,6 +676,8 @@ class Scheduler {
         maxprio = 4;
     }
 
+    virtual ~Scheduler() {}
+
     virtual void add_process(Process* p) {
         p->dynamic_prio = p->static_prio - 1;
         runQ.push_back(p);
@@ -180,7 +692,22 @@ class Scheduler {
         return nullptr;
     }
 
-    virtual bool does_preempt() { return false; }
+    virtual bool does_preempt() { return preemptive; }
+
+    // length of the next CPU slice for p, the fixed quantum by default
+    virtual int timeslice(Process* /*p*/) { return quantum; }
+
+    // p leaves the CPU after running for `ran` ticks
+    virtual void account(Process* /*p*/, int /*ran*/) {}
+
+    virtual void save(SchedulerState& state) {
+        for (auto p : runQ) state.queued.emplace_back(p, 0);
+    }
+
+    // refills an empty scheduler from a state saved by the same policy
+    virtual void restore(const SchedulerState& state) {
+        for (auto& q : state.queued) runQ.push_back(q.first);
+    }
 };
 
 class FCFS : public Scheduler {};
@@ -201,24 +728,56 @@ class LCFS : public Scheduler {
 
 class SRTF : public Scheduler {
    public:
+    // remaining_time does not change while a process is ready, so it can be
+    // the heap key; equal times go to the earliest added process
+    struct Entry {
+        int remaining_time;
+        uint64_t seq;
+        Process* p;
+
+        bool operator<(const Entry& other) const {
+            if (remaining_time != other.remaining_time) {
+                return remaining_time > other.remaining_time;
+            }
+            return seq > other.seq;
+        }
+    };
+
+    std::priority_queue<Entry> readyQ;
+    uint64_t n_added = 0;
+
     SRTF() { name = "SRTF"; }
 
+    void add_process(Process* p) {
+        p->dynamic_prio = p->static_prio - 1;
+        readyQ.push(Entry{p->remaining_time, n_added++, p});
+    }
+
     Process* get_next_process() {
-        if (!runQ.empty()) {
-            // Find the process with the smallest remaining time
-            auto shortest_process = std::min_element(
-                runQ.begin(), runQ.end(),
-                [](const Process* p1, const Process* p2) {
-                    return p1->remaining_time < p2->remaining_time;
-                });
-
-            Process* p = *shortest_process;
-            runQ.erase(shortest_process);
+        if (!readyQ.empty()) {
+            Process* p = readyQ.top().p;
+            readyQ.pop();
             return p;
         }
 
         return nullptr;
     }
+
+    // queued in dispatch order, which restore numbers from 0 again
+    void save(SchedulerState& state) {
+        for (auto copy = readyQ; !copy.empty(); copy.pop()) {
+            state.queued.emplace_back(copy.top().p, 0);
+        }
+        state.counters.push_back(n_added);
+    }
+
+    void restore(const SchedulerState& state) {
+        uint64_t seq = 0;
+        for (auto& q : state.queued) {
+            readyQ.push(Entry{q.first->remaining_time, seq++, q.first});
+        }
+        n_added = state.counters.at(0);
+    }
 };
 
 class RR : public Scheduler {
@@ -229,49 +788,105 @@ class RR : public Scheduler {
     }
 };
 
+// One priority array of the Linux O(1) scheduler: a FIFO per level plus a
+// bitmap of the non-empty levels, so the highest ready level is found with a
+// count-leading-zeros per 64 levels instead of a scan over every queue.
+struct PrioArray {
+    std::vector<std::list<Process*>> levels;
+    std::vector<uint64_t> bitmap;
+    int n_processes = 0;
+
+    PrioArray(int maxprio) : levels(maxprio), bitmap((maxprio + 63) / 64) {}
+
+    bool empty() const { return n_processes == 0; }
+
+    void push(Process* p, int level) {
+        levels[level].push_back(p);
+        bitmap[level / 64] |= 1ULL << (level % 64);
+        n_processes++;
+    }
+
+    Process* pop_highest() {
+        for (int w = bitmap.size() - 1; w >= 0; w--) {
+            if (bitmap[w]) {
+                int level = w * 64 + 63 - __builtin_clzll(bitmap[w]);
+                auto& q = levels[level];
+                Process* p = q.front();
+                q.pop_front();
+                if (q.empty()) bitmap[w] &= ~(1ULL << (level % 64));
+                n_processes--;
+                return p;
+            }
+        }
+        return nullptr;
+    }
+
+    // queued processes, highest level first, tagged offset + level
+    void save(std::vector<std::pair<Process*, int>>& queued, int offset) {
+        for (int level = levels.size() - 1; level >= 0; level--) {
+            for (auto p : levels[level]) queued.emplace_back(p, offset + level);
+        }
+    }
+
+    // moves every process to `level`, higher levels ahead of lower ones
+    void merge_into(int level) {
+        for (int l = levels.size() - 1; l >= 0; l--) {
+            if (l == level) continue;
+            levels[level].splice(levels[level].end(), levels[l]);
+        }
+        std::fill(bitmap.begin(), bitmap.end(), 0);
+        if (n_processes > 0) bitmap[level / 64] |= 1ULL << (level % 64);
+    }
+};
+
 class PRIO : public Scheduler {
    public:
-    std::vector<std::list<Process*>> activeQ;
-    std::vector<std::list<Process*>> expiredQ;
-    PRIO(int quantum, int maxprio = 4) {
+    PrioArray queues[2];
+    PrioArray* activeQ;
+    PrioArray* expiredQ;
+    PRIO(int quantum, int maxprio = 4)
+        : queues{PrioArray(maxprio), PrioArray(maxprio)},
+          activeQ(&queues[0]),
+          expiredQ(&queues[1]) {
         name = "PRIO";
         this->quantum = quantum;
         this->maxprio = maxprio;
-        activeQ.resize(maxprio);
-        expiredQ.resize(maxprio);
     }
 
     void add_process(Process* p) {
         if (p->dynamic_prio < 0) {
             p->dynamic_prio = p->static_prio - 1;
-            expiredQ[p->dynamic_prio].push_back(p);
+            expiredQ->push(p, p->dynamic_prio);
         } else {
-            activeQ[p->dynamic_prio].push_back(p);
+            activeQ->push(p, p->dynamic_prio);
         }
     }
 
     Process* get_next_process() {
-        if (std::all_of(activeQ.begin(), activeQ.end(),
-                        [](std::list<Process*> q) { return q.empty(); }) &&
-            std::all_of(expiredQ.begin(), expiredQ.end(),
-                        [](std::list<Process*> q) { return q.empty(); })) {
-            return nullptr;
+        if (activeQ->empty()) {
+            if (expiredQ->empty()) {
+                return nullptr;
+            }
+            std::swap(activeQ, expiredQ);
         }
 
-        if (std::all_of(activeQ.begin(), activeQ.end(),
-                        [](std::list<Process*> q) { return q.empty(); })) {
-            activeQ.swap(expiredQ);
-        }
+        return activeQ->pop_highest();
+    }
 
-        for (auto it = activeQ.rbegin(); it != activeQ.rend(); ++it) {
-            if (!it->empty()) {
-                auto nextProcess = it->front();
-                it->pop_front();
-                return nextProcess;
+    // expired processes are tagged maxprio + level
+    void save(SchedulerState& state) {
+        activeQ->save(state.queued, 0);
+        expiredQ->save(state.queued, maxprio);
+    }
+
+    void restore(const SchedulerState& state) {
+        for (auto& q : state.queued) {
+            if (q.second < maxprio) {
+                activeQ->push(q.first, q.second);
+            } else {
+                expiredQ->push(q.first, q.second - maxprio);
             }
         }
-
-        return nullptr;
     }
 };
 
@@ -281,193 +896,901 @@ class PREPRIO : public PRIO {
         name = "PREPRIO";
     }
 
-    bool does_preempt() { return true; }
+    static const bool preemptive = true;
+
+    bool does_preempt() { return preemptive; }
 };
 
-std::vector<Process*> create_process_array(std::string filename,
-                                           RandGenerator* rand_generator,
-                                           int maxprio) {
-    int pid = 0;
-    int at, tc, cb, io, sprio;
-    std::ifstream infile(filename);
-    std::string line;
-    std::vector<Process*> process_array;
-    while (std::getline(infile, line)) {
-        std::istringstream iss(line);
-        iss >> at >> tc >> cb >> io;
+// Completely Fair Scheduler model. Ready processes sit in a red-black tree
+// (std::set) keyed by vruntime, the CPU time they received scaled by their
+// weight, and the leftmost one runs next. Slices split the target latency in
+// proportion to weight, but never drop below min_granularity.
+class CFS : public Scheduler {
+   public:
+    struct Entry {
+        long vruntime;
+        uint64_t seq;  // equal vruntimes run in the order they were queued
+        Process* p;
+
+        bool operator<(const Entry& other) const {
+            if (vruntime != other.vruntime) return vruntime < other.vruntime;
+            return seq < other.seq;
+        }
+    };
+
+    std::set<Entry> readyQ;
+    uint64_t n_added = 0;
+    int latency;
+    int min_granularity;
+    long min_vruntime = 0;
+    long ready_weight = 0;  // total weight of readyQ
+
+    CFS(int latency, int min_granularity, int maxprio = 4)
+        : latency(latency), min_granularity(min_granularity) {
+        name = "CFS";
+        this->quantum = latency;
+        this->maxprio = maxprio;
+    }
 
-        sprio = rand_generator->next(maxprio);
-        Process* p = new Process(pid++, at, tc, cb, io, sprio);
-        process_array.push_back(p);
+    // Linux's nice-to-weight table: each nice level is a 1.25x step and
+    // nice 0 weighs 1024
+    static long nice_weight(int nice) {
+        static const long weights[40] = {
+            88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949,
+            11916, 9548,  7620,  6100,  4904,  3906,  3121,  2501,  1991,
+            1586,  1277,  1024,  820,   655,   526,   423,   335,   272,
+            215,   172,   137,   110,   87,    70,    56,    45,    36,
+            29,    23,    18,    15};
+        return weights[std::min(19, std::max(-20, nice)) + 20];
     }
 
-    return process_array;
-}
+    // the middle priority level maps to nice 0, every level above it is one
+    // nice step more important
+    long weight(Process* p) {
+        return nice_weight((maxprio + 1) / 2 - p->static_prio);
+    }
 
-void simulation_loop(DES* des, Scheduler* scheduler,
-                     RandGenerator* rand_generator) {
-    Process* current_running_process = NULL;
-    bool call_scheduler = false;
-    int cpuburst, ioburst;
-    int n_io_blocked = 0;
-    int io_start_time;
+    void add_process(Process* p) {
+        p->dynamic_prio = p->static_prio - 1;
+        // new and woken processes start near the slowest ready one, so time
+        // spent blocked or not yet created does not turn into a CPU credit
+        p->vruntime = std::max(p->vruntime, min_vruntime - latency / 2);
+        readyQ.insert(Entry{p->vruntime, n_added++, p});
+        ready_weight += weight(p);
+    }
 
-    while (!des->empty()) {
-        Event e = des->next_event();
-        auto time_in_state = e.clock - e.p->current_state_start_time;
-        switch (e.transition) {
-            case process_transition::CREATED_TO_READY:
-                if (verbose_mode) {
-                    printf("%d %d %d: CREATED -> READY\n", e.clock, e.p->id,
-                           time_in_state);
-                }
-                e.p->state = process_state::READY;
-                e.p->current_state_start_time = e.clock;
-
-                if ((current_running_process != NULL) &
-                    scheduler->does_preempt()) {
-                    bool cond1 = e.p->dynamic_prio >
-                                 current_running_process->dynamic_prio;
-                    int next_time_for_curr_proc =
-                        des->next_event_time_for_proc(current_running_process);
-                    bool cond2 = next_time_for_curr_proc != e.clock;
-                    if (cond1 && cond2) {
-                        des->delete_event(current_running_process);
-                        current_running_process->preempted = true;
-                        des->add_event(
-                            new Event(e.clock, current_running_process,
-                                      process_transition::RUNNING_TO_READY));
-                    }
-                }
+    Process* get_next_process() {
+        if (readyQ.empty()) {
+            return nullptr;
+        }
+        Process* p = readyQ.begin()->p;
+        readyQ.erase(readyQ.begin());
+        ready_weight -= weight(p);
+        min_vruntime = std::max(min_vruntime, p->vruntime);
+        return p;
+    }
 
-                scheduler->add_process(e.p);
-                call_scheduler = true;
-                break;
-            case process_transition::READY_TO_RUNNING:
-                if (e.p->preempted) {
-                    cpuburst = e.p->current_burst;
-                } else {
-                    cpuburst = rand_generator->next(e.p->cb);
-                    cpuburst = std::min(cpuburst, e.p->remaining_time);
-                    e.p->current_burst = cpuburst;
+    int timeslice(Process* p) {
+        long w = weight(p);
+        long n_running = readyQ.size() + 1;
+        long period = std::max<long>(latency, n_running * min_granularity);
+        long slice = period * w / (ready_weight + w);
+        return std::max<long>(min_granularity, slice);
+    }
+
+    void account(Process* p, int ran) {
+        p->vruntime += (long)ran * nice_weight(0) / weight(p);
+    }
+
+    void save(SchedulerState& state) {
+        for (auto& entry : readyQ) state.queued.emplace_back(entry.p, 0);
+        state.counters.push_back(n_added);
+        state.counters.push_back(min_vruntime);
+    }
+
+    void restore(const SchedulerState& state) {
+        uint64_t seq = 0;
+        for (auto& q : state.queued) {
+            readyQ.insert(Entry{q.first->vruntime, seq++, q.first});
+            ready_weight += weight(q.first);
+        }
+        n_added = state.counters.at(0);
+        min_vruntime = state.counters.at(1);
+    }
+};
+
+// Multi-level feedback queue. A process starts on the top level and drops one
+// level once it has used up its allotment there, whether in one slice or
+// across several bursts; lower levels get twice the allotment of the level
+// above. Every boost_interval ticks all processes go back to the top level.
+// The boost is applied lazily: ready processes are spliced up at the next
+// dispatch and the others are moved when they are next queued.
+class MLFQ : public Scheduler {
+   public:
+    PrioArray queues;
+    int levels;
+    int boost_interval;
+    int now = 0;      // latest clock seen through add_process and account
+    int boosted = 0;  // boost period the ready queues were last merged in
+
+    MLFQ(int quantum, int levels, int boost_interval)
+        : queues(levels), levels(levels), boost_interval(boost_interval) {
+        name = "MLFQ";
+        this->quantum = quantum;
+    }
+
+    int allotment(int level) { return quantum << (levels - 1 - level); }
+
+    // back to the top level if a boost happened since p's level was set
+    void refresh(Process* p) {
+        int period = now / boost_interval + 1;
+        if (p->level_boost < period) {
+            p->level = levels - 1;
+            p->level_time = 0;
+            p->level_boost = period;
+        }
+        p->dynamic_prio = p->level;
+    }
+
+    void add_process(Process* p) {
+        now = std::max(now, p->current_state_start_time);
+        refresh(p);
+        queues.push(p, p->level);
+    }
+
+    Process* get_next_process() {
+        if (now / boost_interval > boosted) {
+            boosted = now / boost_interval;
+            queues.merge_into(levels - 1);
+        }
+        Process* p = queues.pop_highest();
+        if (p) refresh(p);
+        return p;
+    }
+
+    int timeslice(Process* p) { return allotment(p->level) - p->level_time; }
+
+    void account(Process* p, int ran) {
+        now = std::max(now, p->current_state_start_time + ran);
+        p->level_time += ran;
+        if (p->level_time >= allotment(p->level)) {
+            if (p->level > 0) p->level--;
+            p->level_time = 0;
+        }
+    }
+
+    void save(SchedulerState& state) {
+        queues.save(state.queued, 0);
+        state.counters.push_back(now);
+        state.counters.push_back(boosted);
+    }
+
+    void restore(const SchedulerState& state) {
+        for (auto& q : state.queued) queues.push(q.first, q.second);
+        now = state.counters.at(0);
+        boosted = state.counters.at(1);
+    }
+};
+
+// Lottery scheduling with static_prio tickets per process. Ready processes are
+// pooled by ticket count, so a draw picks a pool by scanning maxprio totals
+// and the winner inside it by division, and removal swaps with the last
+// entry. Draws come from the simulation's random file.
+class Lottery : public Scheduler {
+   public:
+    std::vector<std::vector<Process*>> pools;  // pools[t - 1]: t tickets each
+    long total_tickets = 0;
+    RandGenerator* rand_generator;
+
+    Lottery(int quantum, int maxprio, RandGenerator* rand_generator)
+        : pools(maxprio), rand_generator(rand_generator) {
+        name = "LOTTERY";
+        this->quantum = quantum;
+        this->maxprio = maxprio;
+    }
+
+    void add_process(Process* p) {
+        p->dynamic_prio = p->static_prio - 1;
+        pools[p->static_prio - 1].push_back(p);
+        total_tickets += p->static_prio;
+    }
+
+    Process* get_next_process() {
+        if (total_tickets == 0) {
+            return nullptr;
+        }
+        long ticket = rand_generator->next((int)total_tickets) - 1;
+        for (size_t t = 1; t <= pools.size(); t++) {
+            auto& pool = pools[t - 1];
+            long pool_tickets = pool.size() * t;
+            if (ticket < pool_tickets) {
+                size_t winner = ticket / t;
+                Process* p = pool[winner];
+                pool[winner] = pool.back();
+                pool.pop_back();
+                total_tickets -= t;
+                return p;
+            }
+            ticket -= pool_tickets;
+        }
+        return nullptr;
+    }
+
+    // tagged with the pool, kept in pool order so the same draw wins again
+    void save(SchedulerState& state) {
+        for (size_t t = 0; t < pools.size(); t++) {
+            for (auto p : pools[t]) state.queued.emplace_back(p, t);
+        }
+    }
+
+    void restore(const SchedulerState& state) {
+        for (auto& q : state.queued) {
+            pools[q.second].push_back(q.first);
+            total_tickets += q.second + 1;
+        }
+    }
+};
+
+// Stride scheduling: each process holds static_prio tickets and its pass
+// advances by stride1 / tickets per tick it runs; the lowest pass runs next.
+// Processes joining the ready queue start no earlier than the last pass
+// dispatched, so sleeping does not build up a credit.
+class Stride : public Scheduler {
+   public:
+    static const long stride1 = 1 << 20;
+
+    // pass does not change while a process is ready, so it can be the heap
+    // key; equal passes go to the earliest added process
+    struct Entry {
+        long pass;
+        uint64_t seq;
+        Process* p;
+
+        bool operator<(const Entry& other) const {
+            if (pass != other.pass) return pass > other.pass;
+            return seq > other.seq;
+        }
+    };
+
+    std::priority_queue<Entry> readyQ;
+    uint64_t n_added = 0;
+    long global_pass = 0;
+
+    Stride(int quantum, int maxprio = 4) {
+        name = "STRIDE";
+        this->quantum = quantum;
+        this->maxprio = maxprio;
+    }
+
+    void add_process(Process* p) {
+        p->dynamic_prio = p->static_prio - 1;
+        p->vruntime = std::max(p->vruntime, global_pass);
+        readyQ.push(Entry{p->vruntime, n_added++, p});
+    }
+
+    Process* get_next_process() {
+        if (readyQ.empty()) {
+            return nullptr;
+        }
+        Process* p = readyQ.top().p;
+        readyQ.pop();
+        global_pass = std::max(global_pass, p->vruntime);
+        return p;
+    }
+
+    void account(Process* p, int ran) {
+        p->vruntime += ran * (stride1 / p->static_prio);
+    }
+
+    void save(SchedulerState& state) {
+        for (auto copy = readyQ; !copy.empty(); copy.pop()) {
+            state.queued.emplace_back(copy.top().p, 0);
+        }
+        state.counters.push_back(n_added);
+        state.counters.push_back(global_pass);
+    }
+
+    void restore(const SchedulerState& state) {
+        uint64_t seq = 0;
+        for (auto& q : state.queued) {
+            readyQ.push(Entry{q.first->vruntime, seq++, q.first});
+        }
+        n_added = state.counters.at(0);
+        global_pass = state.counters.at(1);
+    }
+};
+
+// one line of the input file, parsed once and shared by every run of a sweep
+struct ProcessInput {
+    int at, tc, cb, io;
+};
+
+std::vector<ProcessInput> read_process_inputs(std::string filename) {
+    int at = 0, tc = 0, cb = 0, io = 0;
+    MappedFile file(filename);
+    Scanner in(file), line(nullptr, nullptr);
+    std::vector<ProcessInput> inputs;
+    while (in.next_line(line)) {
+        // a short line keeps the previous values, as with istringstream
+        line.next(at) && line.next(tc) && line.next(cb) && line.next(io);
+        inputs.push_back(ProcessInput{at, tc, cb, io});
+    }
+
+    return inputs;
+}
+
+// static priorities are drawn here, so the generator must be at the start of
+// the random file for the run to match a standalone invocation
+void create_processes(const std::vector<ProcessInput>& inputs,
+                      RandGenerator* rand_generator, int maxprio,
+                      ProcessTable* processes) {
+    processes->reserve(inputs.size());
+    for (const auto& in : inputs) {
+        int sprio = rand_generator->next(maxprio);
+        processes->add(in.at, in.tc, in.cb, in.io, sprio);
+    }
+}
+
+// how ready processes move between the run queues of an SMP run
+enum class balance_policy { NONE, STEAL, PERIODIC };
+
+struct LoadBalancer {
+    balance_policy policy = balance_policy::NONE;
+    int interval = 0;  // PERIODIC: ticks between rebalances
+};
+
+// The scheduler calls of a simulation loop instantiated for Policy, the exact
+// class of every CPU's scheduler. The calls are qualified, so they are direct
+// and can be inlined, and does_preempt is a compile-time constant. Loops that
+// do not know the policy use the Scheduler instantiation, which dispatches
+// virtually.
+template <typename Policy>
+struct PolicyCalls {
+    static void add_process(Scheduler* s, Process* p) {
+        static_cast<Policy*>(s)->Policy::add_process(p);
+    }
+    static Process* get_next_process(Scheduler* s) {
+        return static_cast<Policy*>(s)->Policy::get_next_process();
+    }
+    static int timeslice(Scheduler* s, Process* p) {
+        return static_cast<Policy*>(s)->Policy::timeslice(p);
+    }
+    static void account(Scheduler* s, Process* p, int ran) {
+        static_cast<Policy*>(s)->Policy::account(p, ran);
+    }
+    static bool does_preempt(Scheduler*) { return Policy::preemptive; }
+};
+
+template <>
+struct PolicyCalls<Scheduler> {
+    static void add_process(Scheduler* s, Process* p) { s->add_process(p); }
+    static Process* get_next_process(Scheduler* s) {
+        return s->get_next_process();
+    }
+    static int timeslice(Scheduler* s, Process* p) { return s->timeslice(p); }
+    static void account(Scheduler* s, Process* p, int ran) {
+        s->account(p, ran);
+    }
+    static bool does_preempt(Scheduler* s) { return s->does_preempt(); }
+};
+
+// one simulated CPU with its own run queue
+struct CPU {
+    Scheduler* scheduler;
+    Process* running = nullptr;
+    int cpuburst = 0;  // burst of the process last dispatched here
+    int n_ready = 0;   // processes in the run queue
+    long busy_time = 0;
+
+    CPU(Scheduler* scheduler) : scheduler(scheduler) {}
+
+    template <typename Policy = Scheduler>
+    void enqueue(Process* p) {
+        PolicyCalls<Policy>::add_process(scheduler, p);
+        n_ready++;
+    }
+
+    template <typename Policy = Scheduler>
+    Process* dequeue() {
+        Process* p = PolicyCalls<Policy>::get_next_process(scheduler);
+        if (p) n_ready--;
+        return p;
+    }
+};
+
+// a new arrival goes to the CPU with the fewest ready and running processes
+int pick_cpu(const std::vector<CPU>& cpus) {
+    int best = 0;
+    for (size_t i = 1; i < cpus.size(); i++) {
+        if (cpus[i].n_ready + (cpus[i].running != nullptr) <
+            cpus[best].n_ready + (cpus[best].running != nullptr)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// idle CPU `thief` takes the next process of the longest other run queue
+template <typename Policy>
+Process* steal_process(DES* des, std::vector<CPU>& cpus, int thief) {
+    int victim = -1;
+    for (size_t i = 0; i < cpus.size(); i++) {
+        if ((int)i != thief && cpus[i].n_ready > 0 &&
+            (victim < 0 || cpus[i].n_ready > cpus[victim].n_ready)) {
+            victim = i;
+        }
+    }
+    if (victim < 0) return nullptr;
+
+    Process* p = cpus[victim].dequeue<Policy>();
+    p->cpu = thief;
+    des->n_migrations++;
+    return p;
+}
+
+// moves processes from the longest to the shortest run queue until their
+// lengths differ by at most one
+template <typename Policy>
+void rebalance(DES* des, std::vector<CPU>& cpus) {
+    while (true) {
+        int busiest = 0, idlest = 0;
+        for (size_t i = 1; i < cpus.size(); i++) {
+            if (cpus[i].n_ready > cpus[busiest].n_ready) busiest = i;
+            if (cpus[i].n_ready < cpus[idlest].n_ready) idlest = i;
+        }
+        if (cpus[busiest].n_ready - cpus[idlest].n_ready <= 1) return;
+
+        Process* p = cpus[busiest].dequeue<Policy>();
+        p->cpu = idlest;
+        cpus[idlest].enqueue<Policy>(p);
+        des->n_migrations++;
+    }
+}
+
+// a process becoming ready on a preemptive CPU preempts the running one if it
+// has a higher priority, unless that one is about to leave the CPU anyway.
+// For a non-preemptive Policy the whole check compiles away.
+template <typename Policy>
+void check_preemption(DES* des, CPU& cpu, Process* p, int clock) {
+    if (PolicyCalls<Policy>::does_preempt(cpu.scheduler) &&
+        cpu.running != nullptr) {
+        bool cond1 = p->dynamic_prio > cpu.running->dynamic_prio;
+        int next_time_for_curr_proc =
+            des->next_event_time_for_proc(cpu.running);
+        bool cond2 = next_time_for_curr_proc != clock;
+        if (cond1 && cond2) {
+            des->delete_event(cpu.running);
+            cpu.running->preempted = true;
+            des->add_event(Event(clock, cpu.running,
+                                 process_transition::RUNNING_TO_READY));
+        }
+    }
+}
+
+// Checkpoint file, native endianness: CheckpointHeader, the Process objects in
+// pid order and the cold arrays of the ProcessTable (at, tc, finish_time,
+// turnaround_time), the live events in firing order, then per CPU a
+// CheckpointCPU followed by its queued (pid, tag) pairs and scheduler
+// counters, and last the latency histograms. The random table itself is not
+// stored, so a resume needs the same random file.
+struct CheckpointHeader {
+    char magic[4];  // "SCKP"
+    uint32_t version;
+    uint32_t process_size;  // sizeof(Process) of the writer
+    int32_t clock;          // every event up to this clock has happened
+    int32_t n_cpus;
+    int32_t maxprio;
+    int32_t rand_index;
+    int32_t total_io_time, n_io_blocked, io_start_time, next_balance;
+    int32_t reserved;
+    uint64_t n_added;
+    int64_t n_migrations;
+    uint64_t n_processes, n_events;
+    char spec[32];  // -s spec of the run, NUL padded
+};
+
+struct CheckpointEvent {
+    int32_t clock, pid, transition, reserved;
+    uint64_t seq;
+};
+
+struct CheckpointCPU {
+    int32_t running;  // pid, -1 if idle
+    int32_t cpuburst;
+    int64_t busy_time;
+    uint64_t n_queued, n_counters;
+};
+
+// where and when a run writes its checkpoint
+struct Checkpoint {
+    int clock;
+    std::string file;
+    std::string spec;
+};
+
+template <typename T>
+void put(FILE* out, const T& value) {
+    fwrite(&value, sizeof(T), 1, out);
+}
+
+void put_histogram(FILE* out, const LatencyHistogram& histogram) {
+    put<uint64_t>(out, histogram.total);
+    put<int64_t>(out, histogram.max_value);
+    fwrite(histogram.counts.data(), sizeof(uint64_t), histogram.counts.size(),
+           out);
+}
+
+// Called between two clocks, when nothing is mid-transition: the DES, the
+// CPUs and the random cursor then describe the whole simulation.
+void write_checkpoint(const Checkpoint& checkpoint, DES* des,
+                      std::vector<CPU>& cpus, RandGenerator* rand_generator) {
+    FILE* out = fopen(checkpoint.file.c_str(), "wb");
+    if (!out) {
+        printf("Cannot open checkpoint file %s. Exiting.\n",
+               checkpoint.file.c_str());
+        exit(EXIT_FAILURE);
+    }
+    std::vector<Event> events = des->pending_events();
+
+    CheckpointHeader header = {};
+    memcpy(header.magic, "SCKP", 4);
+    header.version = 2;
+    header.process_size = sizeof(Process);
+    header.clock = checkpoint.clock;
+    header.n_cpus = cpus.size();
+    header.maxprio = cpus[0].scheduler->maxprio;
+    header.rand_index = rand_generator->rand_index;
+    header.total_io_time = des->total_io_time;
+    header.n_io_blocked = des->n_io_blocked;
+    header.io_start_time = des->io_start_time;
+    header.next_balance = des->next_balance;
+    header.n_added = des->n_added;
+    header.n_migrations = des->n_migrations;
+    header.n_processes = des->processes->size();
+    header.n_events = events.size();
+    strncpy(header.spec, checkpoint.spec.c_str(), sizeof(header.spec) - 1);
+    put(out, header);
+
+    ProcessTable* processes = des->processes;
+    size_t n = processes->size();
+    fwrite(processes->process(0), sizeof(Process), n, out);
+    fwrite(processes->at.data(), sizeof(int), n, out);
+    fwrite(processes->tc.data(), sizeof(int), n, out);
+    fwrite(processes->finish_time.data(), sizeof(int), n, out);
+    fwrite(processes->turnaround_time.data(), sizeof(int), n, out);
+    for (auto& e : events) {
+        put(out, CheckpointEvent{e.clock, e.pid, (int)e.transition, 0, e.seq});
+    }
+    for (auto& cpu : cpus) {
+        SchedulerState state;
+        cpu.scheduler->save(state);
+        put(out, CheckpointCPU{cpu.running ? cpu.running->id : -1,
+                               cpu.cpuburst, cpu.busy_time,
+                               state.queued.size(), state.counters.size()});
+        for (auto& q : state.queued) {
+            put<int32_t>(out, q.first->id);
+            put<int32_t>(out, q.second);
+        }
+        for (long counter : state.counters) {
+            put<int64_t>(out, counter);
+        }
+    }
+
+    put<uint64_t>(out, des->latency.wait_by_prio.size());
+    put_histogram(out, des->latency.wait);
+    put_histogram(out, des->latency.response);
+    for (auto& histogram : des->latency.wait_by_prio) {
+        put_histogram(out, histogram);
+    }
+    fclose(out);
+}
+
+// bounds-checked cursor over a mapped checkpoint
+class CheckpointReader {
+   public:
+    explicit CheckpointReader(const MappedFile& file)
+        : pos(file.begin()), end(file.end()) {}
+
+    void read(void* dest, size_t size) {
+        if ((size_t)(end - pos) < size) {
+            printf("Truncated checkpoint file. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(dest, pos, size);
+        pos += size;
+    }
+
+    template <typename T>
+    T get() {
+        T value;
+        read(&value, sizeof(T));
+        return value;
+    }
+
+   private:
+    const char* pos;
+    const char* end;
+};
+
+void get_histogram(CheckpointReader& in, LatencyHistogram& histogram) {
+    histogram.total = in.get<uint64_t>();
+    histogram.max_value = in.get<int64_t>();
+    in.read(histogram.counts.data(),
+            sizeof(uint64_t) * histogram.counts.size());
+}
+
+// Rebuilds the DES, the CPUs and the random cursor from a checkpoint. With
+// the spec the checkpoint was taken under, the run queues are restored as
+// they were and the run continues exactly as the original did. Under any
+// other policy the per-policy process state is cleared and the ready
+// processes are added to the new scheduler in the order they became ready.
+void restore_checkpoint(const std::string& filename, const std::string& spec,
+                        DES* des, std::vector<CPU>& cpus,
+                        ProcessTable* processes,
+                        RandGenerator* rand_generator) {
+    static_assert(std::is_trivially_copyable<Process>::value,
+                  "Process is stored byte for byte");
+    MappedFile file(filename);
+    CheckpointReader in(file);
+    auto header = in.get<CheckpointHeader>();
+    if (memcmp(header.magic, "SCKP", 4) || header.version != 2 ||
+        header.process_size != sizeof(Process)) {
+        printf("Not a scheduler checkpoint. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (header.n_cpus != (int)cpus.size()) {
+        printf("Checkpoint was taken with %d CPUs. Exiting.\n",
+               header.n_cpus);
+        exit(EXIT_FAILURE);
+    }
+    if (header.maxprio > cpus[0].scheduler->maxprio) {
+        printf("Checkpoint needs a maxprio of at least %d. Exiting.\n",
+               header.maxprio);
+        exit(EXIT_FAILURE);
+    }
+    header.spec[sizeof(header.spec) - 1] = 0;
+    bool same_policy = spec == header.spec;
+
+    rand_generator->rand_index = header.rand_index;
+    des->total_io_time = header.total_io_time;
+    des->n_io_blocked = header.n_io_blocked;
+    des->io_start_time = header.io_start_time;
+    des->next_balance = header.next_balance;
+    des->n_added = header.n_added;
+    des->n_migrations = header.n_migrations;
+
+    size_t n = header.n_processes;
+    processes->reserve(n);
+    for (size_t pid = 0; pid < n; pid++) {
+        Process* p = processes->add(0, 0, 0, 0, 0);
+        in.read(p, sizeof(Process));
+        p->pending_seq = 0;
+        if (!same_policy) p->reset_policy_state();
+    }
+    in.read(processes->at.data(), sizeof(int) * n);
+    in.read(processes->tc.data(), sizeof(int) * n);
+    in.read(processes->finish_time.data(), sizeof(int) * n);
+    in.read(processes->turnaround_time.data(), sizeof(int) * n);
+    auto process = [&](int pid) {
+        if (pid < 0 || (size_t)pid >= n) {
+            printf("Corrupt checkpoint file. Exiting.\n");
+            exit(EXIT_FAILURE);
+        }
+        return processes->process(pid);
+    };
+
+    for (uint64_t i = 0; i < header.n_events; i++) {
+        auto record = in.get<CheckpointEvent>();
+        Process* p = process(record.pid);
+        Event e(record.clock, p, (process_transition)record.transition);
+        e.seq = record.seq;
+        p->pending_seq = e.seq;
+        p->pending_clock = e.clock;
+        des->eventQ->push(e);
+    }
+
+    for (auto& cpu : cpus) {
+        auto record = in.get<CheckpointCPU>();
+        cpu.running = record.running < 0 ? nullptr : process(record.running);
+        cpu.cpuburst = record.cpuburst;
+        cpu.busy_time = record.busy_time;
+        cpu.n_ready = record.n_queued;
+
+        SchedulerState state;
+        for (uint64_t i = 0; i < record.n_queued; i++) {
+            Process* p = process(in.get<int32_t>());
+            state.queued.emplace_back(p, in.get<int32_t>());
+        }
+        for (uint64_t i = 0; i < record.n_counters; i++) {
+            state.counters.push_back(in.get<int64_t>());
+        }
+
+        if (same_policy) {
+            cpu.scheduler->restore(state);
+        } else {
+            std::stable_sort(state.queued.begin(), state.queued.end(),
+                             [](const std::pair<Process*, int>& a,
+                                const std::pair<Process*, int>& b) {
+                                 return a.first->current_state_start_time <
+                                        b.first->current_state_start_time;
+                             });
+            for (auto& q : state.queued) cpu.scheduler->add_process(q.first);
+        }
+    }
+
+    des->latency.wait_by_prio.resize(in.get<uint64_t>());
+    get_histogram(in, des->latency.wait);
+    get_histogram(in, des->latency.response);
+    for (auto& histogram : des->latency.wait_by_prio) {
+        get_histogram(in, histogram);
+    }
+}
+
+// Simulates len(cpus) CPUs sharing one I/O subsystem. Each process stays on
+// its CPU's run queue unless the balancer migrates it; with a single CPU this
+// is the classic uniprocessor simulation. Every transition is handed to the
+// tracer, so an untraced loop instantiated with NullTracer has no trace code.
+// Likewise the loop is instantiated per scheduling policy (see PolicyCalls).
+template <typename Policy, typename Tracer>
+void simulation_loop(DES* des, std::vector<CPU>& cpus,
+                     const LoadBalancer& balancer,
+                     RandGenerator* rand_generator, Tracer& tracer,
+                     const Checkpoint* checkpoint = nullptr) {
+    typedef PolicyCalls<Policy> Calls;
+    bool call_scheduler = false;
+    int cpuburst, ioburst;
+
+    while (!des->empty()) {
+        // between two clocks, once the last one has been fully scheduled
+        if (checkpoint && !call_scheduler &&
+            des->next_event_time() > checkpoint->clock) {
+            write_checkpoint(*checkpoint, des, cpus, rand_generator);
+            checkpoint = nullptr;
+        }
+
+        Event e = des->next_event();
+        Process* p = des->process(e);
+        auto time_in_state = e.clock - p->current_state_start_time;
+        switch (e.transition) {
+            case process_transition::CREATED_TO_READY: {
+                tracer.record(make_trace_record(e.clock, p->id, time_in_state,
+                                                e.transition));
+                p->state = process_state::READY;
+                p->current_state_start_time = e.clock;
+
+                p->cpu = pick_cpu(cpus);
+                check_preemption<Policy>(des, cpus[p->cpu], p, e.clock);
+
+                cpus[p->cpu].enqueue<Policy>(p);
+                call_scheduler = true;
+                break;
+            }
+            case process_transition::READY_TO_RUNNING: {
+                CPU& cpu = cpus[p->cpu];
+                // current_burst is -1 until the first burst is drawn
+                bool first_dispatch = p->current_burst < 0;
+                if (p->preempted) {
+                    cpuburst = p->current_burst;
+                } else {
+                    cpuburst = rand_generator->next(p->cb);
+                    cpuburst = std::min(cpuburst, p->remaining_time);
+                    p->current_burst = cpuburst;
                 }
 
-                if (verbose_mode) {
-                    printf("%d %d %d: READY -> RUNNG cb=%d rem=%d prio=%d\n",
-                           e.clock, e.p->id, time_in_state, cpuburst,
-                           e.p->remaining_time, e.p->dynamic_prio);
+                tracer.record(make_trace_record(
+                    e.clock, p->id, time_in_state, e.transition, cpuburst,
+                    p->remaining_time, p->dynamic_prio));
+                des->latency.record_dispatch(p, time_in_state);
+                if (first_dispatch) {
+                    des->latency.response.record(
+                        e.clock - des->processes->at[p->id]);
                 }
-                e.p->state = process_state::RUNNING;
-                e.p->current_state_start_time = e.clock;
-                current_running_process = e.p;
+                p->state = process_state::RUNNING;
+                p->current_state_start_time = e.clock;
+                cpu.running = p;
+                cpu.cpuburst = cpuburst;
 
-                e.p->waiting_time += time_in_state;
-                e.p->preempted = false;
+                p->waiting_time += time_in_state;
+                p->preempted = false;
 
-                if (scheduler->quantum < cpuburst) {
+                int slice = Calls::timeslice(cpu.scheduler, p);
+                if (slice < cpuburst) {
                     des->add_event(
-                        new Event(e.clock + scheduler->quantum, e.p,
-                                  process_transition::RUNNING_TO_READY));
+                        Event(e.clock + slice, p,
+                              process_transition::RUNNING_TO_READY));
 
                 } else {
-                    if (cpuburst >= e.p->remaining_time) {
+                    if (cpuburst >= p->remaining_time) {
                         des->add_event(
-                            new Event(e.clock + cpuburst, e.p,
-                                      process_transition::RUNNING_TO_DONE));
+                            Event(e.clock + cpuburst, p,
+                                  process_transition::RUNNING_TO_DONE));
                     } else {
                         des->add_event(
-                            new Event(e.clock + cpuburst, e.p,
-                                      process_transition::RUNNING_TO_BLOCKED));
+                            Event(e.clock + cpuburst, p,
+                                  process_transition::RUNNING_TO_BLOCKED));
                     }
                 }
                 break;
-            case process_transition::RUNNING_TO_READY:
-                e.p->remaining_time -= time_in_state;
-                e.p->current_burst -= time_in_state;
-                current_running_process = NULL;
-
-                if (verbose_mode) {
-                    printf("%d %d %d: RUNNG -> READY cb=%d rem=%d prio=%d\n",
-                           e.clock, e.p->id, time_in_state, cpuburst,
-                           e.p->remaining_time, e.p->dynamic_prio);
-                }
-                e.p->state = process_state::READY;
-                e.p->current_state_start_time = e.clock;
-
-                e.p->dynamic_prio -= 1;
-                scheduler->add_process(e.p);
-
-                e.p->preempted = true;
+            }
+            case process_transition::RUNNING_TO_READY: {
+                CPU& cpu = cpus[p->cpu];
+                p->remaining_time -= time_in_state;
+                p->current_burst -= time_in_state;
+                cpu.running = NULL;
+                cpu.busy_time += time_in_state;
+                Calls::account(cpu.scheduler, p, time_in_state);
+
+                tracer.record(make_trace_record(
+                    e.clock, p->id, time_in_state, e.transition,
+                    cpu.cpuburst, p->remaining_time, p->dynamic_prio));
+                p->state = process_state::READY;
+                p->current_state_start_time = e.clock;
+
+                p->dynamic_prio -= 1;
+                cpu.enqueue<Policy>(p);
+
+                p->preempted = true;
                 call_scheduler = true;
                 break;
-            case process_transition::RUNNING_TO_BLOCKED:
-                e.p->remaining_time -= time_in_state;
-                current_running_process = NULL;
-                ioburst = rand_generator->next(e.p->io);
-
-                if (n_io_blocked == 0) {
-                    io_start_time = e.clock;
+            }
+            case process_transition::RUNNING_TO_BLOCKED: {
+                CPU& cpu = cpus[p->cpu];
+                p->remaining_time -= time_in_state;
+                cpu.running = NULL;
+                cpu.busy_time += time_in_state;
+                Calls::account(cpu.scheduler, p, time_in_state);
+                ioburst = rand_generator->next(p->io);
+
+                if (des->n_io_blocked == 0) {
+                    des->io_start_time = e.clock;
                 }
 
-                n_io_blocked++;
-                if (verbose_mode) {
-                    printf("%d %d %d: RUNNG -> BLOCK  ib=%d rem=%d\n", e.clock,
-                           e.p->id, time_in_state, ioburst,
-                           e.p->remaining_time);
-                }
-                e.p->state = process_state::BLOCKED;
-                e.p->current_state_start_time = e.clock;
+                des->n_io_blocked++;
+                tracer.record(make_trace_record(e.clock, p->id, time_in_state,
+                                                e.transition, ioburst,
+                                                p->remaining_time));
+                p->state = process_state::BLOCKED;
+                p->current_state_start_time = e.clock;
 
-                des->add_event(new Event(e.clock + ioburst, e.p,
-                                         process_transition::BLOCKED_TO_READY));
+                des->add_event(Event(e.clock + ioburst, p,
+                                     process_transition::BLOCKED_TO_READY));
                 call_scheduler = true;
                 break;
-            case process_transition::BLOCKED_TO_READY:
-                n_io_blocked -= 1;
-                if (n_io_blocked == 0) {
-                    des->total_io_time += e.clock - io_start_time;
-                }
-
-                e.p->dynamic_prio = e.p->static_prio - 1;
-                e.p->io_time += time_in_state;
-                if (verbose_mode) {
-                    printf("%d %d %d: BLOCK -> READY\n", e.clock, e.p->id,
-                           time_in_state);
+            }
+            case process_transition::BLOCKED_TO_READY: {
+                des->n_io_blocked -= 1;
+                if (des->n_io_blocked == 0) {
+                    des->total_io_time += e.clock - des->io_start_time;
                 }
-                e.p->state = process_state::READY;
-                e.p->current_state_start_time = e.clock;
-
-                if ((current_running_process != nullptr) &
-                    (scheduler->does_preempt())) {
-                    bool cond1 = e.p->dynamic_prio >
-                                 current_running_process->dynamic_prio;
 
-                    int next_time_for_curr_proc =
-                        des->next_event_time_for_proc(current_running_process);
+                p->dynamic_prio = p->static_prio - 1;
+                p->io_time += time_in_state;
+                tracer.record(make_trace_record(e.clock, p->id, time_in_state,
+                                                e.transition));
+                p->state = process_state::READY;
+                p->current_state_start_time = e.clock;
 
-                    bool cond2 = next_time_for_curr_proc != e.clock;
-                    if (cond1 && cond2) {
-                        des->delete_event(current_running_process);
-                        current_running_process->preempted = true;
-                        des->add_event(
-                            new Event(e.clock, current_running_process,
-                                      process_transition::RUNNING_TO_READY));
-                    }
-                }
+                // back to the CPU it last ran on
+                check_preemption<Policy>(des, cpus[p->cpu], p, e.clock);
 
-                scheduler->add_process(e.p);
+                cpus[p->cpu].enqueue<Policy>(p);
                 call_scheduler = true;
                 break;
-            case process_transition::RUNNING_TO_DONE:
-                e.p->remaining_time -= time_in_state;
-                current_running_process = NULL;
-                if (verbose_mode) {
-                    printf("%d %d %d: Done\n", e.clock, e.p->id, time_in_state);
-                }
-                e.p->finish_time = e.clock;
-                e.p->turnaround_time = e.p->finish_time - e.p->at;
+            }
+            case process_transition::RUNNING_TO_DONE: {
+                CPU& cpu = cpus[p->cpu];
+                p->remaining_time -= time_in_state;
+                cpu.running = NULL;
+                cpu.busy_time += time_in_state;
+                Calls::account(cpu.scheduler, p, time_in_state);
+                tracer.record(make_trace_record(e.clock, p->id, time_in_state,
+                                                e.transition));
+                des->processes->finish_time[p->id] = e.clock;
+                des->processes->turnaround_time[p->id] =
+                    e.clock - des->processes->at[p->id];
                 call_scheduler = true;
                 break;
+            }
         }
 
         if (call_scheduler) {
@@ -475,67 +1798,587 @@ void simulation_loop(DES* des, Scheduler* scheduler,
                 continue;
             } else {
                 call_scheduler = false;
-                if (current_running_process == nullptr) {
-                    auto proc = scheduler->get_next_process();
+                if (balancer.policy == balance_policy::PERIODIC &&
+                    e.clock >= des->next_balance) {
+                    rebalance<Policy>(des, cpus);
+                    des->next_balance = (e.clock / balancer.interval + 1) *
+                                        balancer.interval;
+                }
+                for (size_t i = 0; i < cpus.size(); i++) {
+                    if (cpus[i].running != nullptr) continue;
+                    auto proc = cpus[i].dequeue<Policy>();
+                    if (proc == nullptr &&
+                        balancer.policy == balance_policy::STEAL) {
+                        proc = steal_process<Policy>(des, cpus, i);
+                    }
                     if (proc != nullptr) {
                         des->add_event(
-                            new Event(e.clock, proc,
-                                      process_transition::READY_TO_RUNNING));
+                            Event(e.clock, proc,
+                                  process_transition::READY_TO_RUNNING));
                     }
                 }
             }
         }
     }
-}
 
-void print_summary(DES* des, Scheduler* scheduler) {
-    if (scheduler->quantum < 1e4) {
-        printf("%s %d\n", scheduler->name.c_str(), scheduler->quantum);
-    } else {
-        printf("%s\n", scheduler->name.c_str());
+    if (checkpoint) {
+        fprintf(stderr, "No checkpoint: the run ended before time %d.\n",
+                checkpoint->clock);
     }
-    for (auto p : des->process_array) {
-        printf("%04d: %4d %4d %4d %4d %1d | %5d %5d %5d %5d\n", p->id, p->at,
-               p->tc, p->cb, p->io, p->static_prio, p->finish_time,
-               p->turnaround_time, p->io_time, p->waiting_time);
+
+    des->cpu_busy_time.clear();
+    for (auto& cpu : cpus) {
+        des->cpu_busy_time.push_back(cpu.busy_time);
     }
+}
 
-    int num_processes = des->process_array.size();
+// totals of the SUM line
+struct RunSummary {
+    int finishtime;
+    double cpu_util, io_util, avg_tat, avg_wait, throughput;
+};
+
+RunSummary summarize(DES* des) {
+    const ProcessTable& processes = *des->processes;
+    int num_processes = processes.size();
     int finishtime = 0;
     double cpu_time = 0;
     double total_tat = 0;
     double total_wait = 0;
-    for (auto p : des->process_array) {
-        cpu_time += p->tc;
-        total_tat += p->turnaround_time;
-        total_wait += p->waiting_time;
+    for (int pid = 0; pid < num_processes; pid++) {
+        cpu_time += processes.tc[pid];
+        total_tat += processes.turnaround_time[pid];
+        total_wait += processes.process(pid)->waiting_time;
+
+        finishtime = std::max(finishtime, processes.finish_time[pid]);
+    }
+
+    // with several CPUs utilization is averaged over all of them
+    int n_cpus = std::max<size_t>(1, des->cpu_busy_time.size());
+
+    RunSummary sum;
+    sum.finishtime = finishtime;
+    sum.avg_tat = total_tat / num_processes;
+    sum.avg_wait = total_wait / num_processes;
+
+    sum.cpu_util = 100.0 * (cpu_time / ((double)finishtime * n_cpus));
+    sum.io_util = 100.0 * (des->total_io_time / (double)finishtime);
+    sum.throughput = 100.0 * (num_processes / (double)finishtime);
+    return sum;
+}
+
+void print_summary(DES* des, Scheduler* scheduler, FILE* out = stdout) {
+    if (scheduler->quantum < 1e4) {
+        fprintf(out, "%s %d\n", scheduler->name.c_str(), scheduler->quantum);
+    } else {
+        fprintf(out, "%s\n", scheduler->name.c_str());
+    }
+    const ProcessTable& processes = *des->processes;
+    for (size_t pid = 0; pid < processes.size(); pid++) {
+        Process* p = processes.process(pid);
+        fprintf(out, "%04d: %4d %4d %4d %4d %1d | %5d %5d %5d %5d\n", p->id,
+                processes.at[pid], processes.tc[pid], p->cb, p->io,
+                p->static_prio, processes.finish_time[pid],
+                processes.turnaround_time[pid], p->io_time, p->waiting_time);
+    }
+
+    RunSummary sum = summarize(des);
+    fprintf(out, "SUM: %d %.2lf %.2lf %.2lf %.2lf %.3lf\n", sum.finishtime,
+            sum.cpu_util, sum.io_util, sum.avg_tat, sum.avg_wait,
+            sum.throughput);
+
+    if (des->cpu_busy_time.size() > 1) {
+        for (size_t i = 0; i < des->cpu_busy_time.size(); i++) {
+            fprintf(out, "CPU[%zu]: busy=%ld util=%.2lf\n", i,
+                    des->cpu_busy_time[i],
+                    100.0 * des->cpu_busy_time[i] / sum.finishtime);
+        }
+        fprintf(out, "MIGRATIONS: %ld\n", des->n_migrations);
+    }
+}
+
+void print_percentiles(FILE* out, const char* label,
+                       const LatencyHistogram& histogram) {
+    fprintf(out, "%s: n=%llu p50=%ld p99=%ld p99.9=%ld max=%ld\n", label,
+            (unsigned long long)histogram.total, histogram.percentile(50),
+            histogram.percentile(99), histogram.percentile(99.9),
+            histogram.max_value);
+}
+
+// percentile lines for -l, printed after the SUM line; PRIO and PREPRIO also
+// get the wait time of each priority level, highest first
+void print_latency(DES* des, Scheduler* scheduler, FILE* out) {
+    print_percentiles(out, "WAIT", des->latency.wait);
+    print_percentiles(out, "RESP", des->latency.response);
+    if (dynamic_cast<PRIO*>(scheduler)) {
+        auto& by_prio = des->latency.wait_by_prio;
+        for (int prio = by_prio.size() - 1; prio >= 0; prio--) {
+            char label[32];
+            snprintf(label, sizeof(label), "PRIO[%d] WAIT", prio);
+            print_percentiles(out, label, by_prio[prio]);
+        }
+    }
+}
+
+enum class output_format { TEXT, JSONL, BINARY };
+
+// appends the decimal form of value, the per-process rows are built with this
+// instead of printf
+void append_int(std::string& buffer, long value) {
+    char digits[24];
+    int n = 0;
+    bool negative = value < 0;
+    unsigned long v = negative ? -(unsigned long)value : value;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    if (negative) buffer += '-';
+    while (n) buffer += digits[--n];
+}
+
+void append_field(std::string& buffer, const char* key, long value) {
+    buffer += ",\"";
+    buffer += key;
+    buffer += "\":";
+    append_int(buffer, value);
+}
+
+// fields that open every JSON line of a run
+std::string jsonl_head(Scheduler* scheduler) {
+    std::string head = "{\"sched\":\"" + scheduler->name + "\"";
+    append_field(head, "quantum", scheduler->quantum);
+    append_field(head, "maxprio", scheduler->maxprio);
+    return head;
+}
+
+// One JSON object per line: a "proc" record for every process followed by a
+// "sum" record with the SUM line fields.
+void write_summary_jsonl(DES* des, Scheduler* scheduler, FILE* out) {
+    std::string head = jsonl_head(scheduler);
+
+    std::string buffer;
+    const ProcessTable& processes = *des->processes;
+    for (size_t pid = 0; pid < processes.size(); pid++) {
+        Process* p = processes.process(pid);
+        buffer += head;
+        buffer += ",\"type\":\"proc\"";
+        append_field(buffer, "pid", p->id);
+        append_field(buffer, "at", processes.at[pid]);
+        append_field(buffer, "tc", processes.tc[pid]);
+        append_field(buffer, "cb", p->cb);
+        append_field(buffer, "io", p->io);
+        append_field(buffer, "prio", p->static_prio);
+        append_field(buffer, "finish", processes.finish_time[pid]);
+        append_field(buffer, "tat", processes.turnaround_time[pid]);
+        append_field(buffer, "iotime", p->io_time);
+        append_field(buffer, "wait", p->waiting_time);
+        buffer += "}\n";
+        if (buffer.size() > (1 << 16)) {
+            fwrite(buffer.data(), 1, buffer.size(), out);
+            buffer.clear();
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), out);
+
+    RunSummary sum = summarize(des);
+    fprintf(out,
+            "%s,\"type\":\"sum\",\"finish\":%d,\"cpu_util\":%.6f,"
+            "\"io_util\":%.6f,\"avg_tat\":%.6f,\"avg_wait\":%.6f,"
+            "\"throughput\":%.6f}\n",
+            head.c_str(), sum.finishtime, sum.cpu_util, sum.io_util,
+            sum.avg_tat, sum.avg_wait, sum.throughput);
+}
+
+void append_percentiles(std::string& buffer,
+                        const LatencyHistogram& histogram) {
+    append_field(buffer, "n", histogram.total);
+    append_field(buffer, "p50", histogram.percentile(50));
+    append_field(buffer, "p99", histogram.percentile(99));
+    append_field(buffer, "p999", histogram.percentile(99.9));
+    append_field(buffer, "max", histogram.max_value);
+}
+
+// the -l percentiles as "wait" and "resp" records, plus one "wait" record
+// with a "prio" field per level for PRIO and PREPRIO
+void write_latency_jsonl(DES* des, Scheduler* scheduler, FILE* out) {
+    std::string head = jsonl_head(scheduler);
+    std::string buffer = head + ",\"type\":\"wait\"";
+    append_percentiles(buffer, des->latency.wait);
+    buffer += "}\n" + head + ",\"type\":\"resp\"";
+    append_percentiles(buffer, des->latency.response);
+    buffer += "}\n";
+    if (dynamic_cast<PRIO*>(scheduler)) {
+        auto& by_prio = des->latency.wait_by_prio;
+        for (int prio = by_prio.size() - 1; prio >= 0; prio--) {
+            buffer += head + ",\"type\":\"wait\"";
+            append_field(buffer, "prio", prio);
+            append_percentiles(buffer, by_prio[prio]);
+            buffer += "}\n";
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), out);
+}
+
+// Binary layout, native endianness, one block per run:
+//   BinaryHeader, n_processes x BinaryProcess, BinarySum
+struct BinaryHeader {
+    char magic[4];  // "SCHD"
+    uint32_t version;
+    char sched[8];  // scheduler name, NUL padded
+    int32_t quantum;
+    int32_t maxprio;
+    uint32_t n_processes;
+};
+
+struct BinaryProcess {
+    int32_t pid, at, tc, cb, io, prio;
+    int32_t finish, tat, io_time, wait;
+};
+
+struct BinarySum {
+    int32_t finishtime;
+    int32_t reserved;
+    double cpu_util, io_util, avg_tat, avg_wait, throughput;
+};
+
+void write_summary_binary(DES* des, Scheduler* scheduler, FILE* out) {
+    BinaryHeader header = {};
+    memcpy(header.magic, "SCHD", 4);
+    header.version = 1;
+    memcpy(header.sched, scheduler->name.data(),
+           std::min(scheduler->name.size(), sizeof(header.sched)));
+    header.quantum = scheduler->quantum;
+    header.maxprio = scheduler->maxprio;
+    const ProcessTable& processes = *des->processes;
+    header.n_processes = processes.size();
+    fwrite(&header, sizeof(header), 1, out);
+
+    std::vector<BinaryProcess> records;
+    records.reserve(processes.size());
+    for (size_t pid = 0; pid < processes.size(); pid++) {
+        Process* p = processes.process(pid);
+        records.push_back(BinaryProcess{
+            p->id, processes.at[pid], processes.tc[pid], p->cb, p->io,
+            p->static_prio, processes.finish_time[pid],
+            processes.turnaround_time[pid], p->io_time, p->waiting_time});
+    }
+    fwrite(records.data(), sizeof(BinaryProcess), records.size(), out);
+
+    RunSummary sum = summarize(des);
+    BinarySum record = {sum.finishtime, 0,           sum.cpu_util,
+                        sum.io_util,    sum.avg_tat, sum.avg_wait,
+                        sum.throughput};
+    fwrite(&record, sizeof(record), 1, out);
+}
+
+// latency adds the -l percentiles; the binary format has no place for them
+void report_summary(DES* des, Scheduler* scheduler, FILE* out,
+                    output_format format, bool latency = false) {
+    switch (format) {
+        case output_format::TEXT:
+            print_summary(des, scheduler, out);
+            if (latency) print_latency(des, scheduler, out);
+            break;
+        case output_format::JSONL:
+            write_summary_jsonl(des, scheduler, out);
+            if (latency) write_latency_jsonl(des, scheduler, out);
+            break;
+        case output_format::BINARY:
+            write_summary_binary(des, scheduler, out);
+            break;
+    }
+}
+
+// peak resident set size of this process, reported on stderr so stdout
+// stays comparable with reference outputs
+void print_peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stderr, "PEAKRSS: %ld KB\n", usage.ru_maxrss);
+}
+
+// builds the scheduler for one -s spec such as "R5" or "E2:5", nullptr if the
+// spec is not valid; lottery draws come from rand_generator
+Scheduler* make_scheduler(const std::string& spec,
+                          RandGenerator* rand_generator = nullptr) {
+    if (spec.empty()) {
+        return nullptr;
+    }
+    const char* args = spec.c_str() + 1;
+    const char* maxprio_str = strchr(args, ':');
+    switch (spec[0]) {
+        case 'F':
+            return new FCFS();
+        case 'L':
+            return new LCFS();
+        case 'S':
+            return new SRTF();
+        case 'R':
+            return new RR(atoi(args));
+        case 'P':
+            if (maxprio_str) {
+                return new PRIO(atoi(args), atoi(maxprio_str + 1));
+            }
+            return new PRIO(atoi(args));
+        case 'E':
+            if (maxprio_str) {
+                return new PREPRIO(atoi(args), atoi(maxprio_str + 1));
+            }
+            return new PREPRIO(atoi(args));
+        case 'C': {
+            // C[<latency>[:<min_granularity>[:<maxprio>]]]
+            int latency = 24, min_granularity = 3, maxprio = 4;
+            sscanf(args, "%d:%d:%d", &latency, &min_granularity, &maxprio);
+            if (latency < 1 || min_granularity < 1 || maxprio < 1) {
+                return nullptr;
+            }
+            return new CFS(latency, min_granularity, maxprio);
+        }
+        case 'M': {
+            // M<quantum>[:<levels>[:<boost_interval>]]
+            int quantum = 0, levels = 3, boost_interval = 0;
+            sscanf(args, "%d:%d:%d", &quantum, &levels, &boost_interval);
+            if (boost_interval == 0) {
+                boost_interval =
+                    quantum > INT_MAX / 100 ? INT_MAX : 100 * quantum;
+            }
+            if (quantum < 1 || levels < 1 || levels > 16 ||
+                boost_interval < 1) {
+                return nullptr;
+            }
+            // the bottom level's allotment, quantum << (levels - 1), must fit
+            if (quantum > (INT_MAX >> (levels - 1))) {
+                return nullptr;
+            }
+            return new MLFQ(quantum, levels, boost_interval);
+        }
+        case 'T': {
+            int maxprio = maxprio_str ? atoi(maxprio_str + 1) : 4;
+            if (atoi(args) < 1 || maxprio < 1) return nullptr;
+            return new Lottery(atoi(args), maxprio, rand_generator);
+        }
+        case 'W': {
+            int maxprio = maxprio_str ? atoi(maxprio_str + 1) : 4;
+            if (atoi(args) < 1 || maxprio < 1) return nullptr;
+            return new Stride(atoi(args), maxprio);
+        }
+    }
+    return nullptr;
+}
+
+// runs the loop instantiated for the class make_scheduler built from spec
+template <typename Tracer>
+void policy_loop(const std::string& spec, DES* des, std::vector<CPU>& cpus,
+                 const LoadBalancer& balancer, RandGenerator* rand_generator,
+                 Tracer& tracer, const Checkpoint* checkpoint) {
+    switch (spec[0]) {
+        case 'F':
+            return simulation_loop<FCFS>(des, cpus, balancer, rand_generator,
+                                         tracer, checkpoint);
+        case 'L':
+            return simulation_loop<LCFS>(des, cpus, balancer, rand_generator,
+                                         tracer, checkpoint);
+        case 'S':
+            return simulation_loop<SRTF>(des, cpus, balancer, rand_generator,
+                                         tracer, checkpoint);
+        case 'R':
+            return simulation_loop<RR>(des, cpus, balancer, rand_generator,
+                                       tracer, checkpoint);
+        case 'P':
+            return simulation_loop<PRIO>(des, cpus, balancer, rand_generator,
+                                         tracer, checkpoint);
+        case 'E':
+            return simulation_loop<PREPRIO>(des, cpus, balancer,
+                                            rand_generator, tracer, checkpoint);
+        case 'C':
+            return simulation_loop<CFS>(des, cpus, balancer, rand_generator,
+                                        tracer, checkpoint);
+        case 'M':
+            return simulation_loop<MLFQ>(des, cpus, balancer, rand_generator,
+                                         tracer, checkpoint);
+        case 'T':
+            return simulation_loop<Lottery>(des, cpus, balancer,
+                                            rand_generator, tracer, checkpoint);
+        case 'W':
+            return simulation_loop<Stride>(des, cpus, balancer, rand_generator,
+                                           tracer, checkpoint);
+    }
+    simulation_loop<Scheduler>(des, cpus, balancer, rand_generator, tracer,
+                               checkpoint);
+}
+
+// where the runs of a sweep get their processes from: records parsed once up
+// front, or the input file streamed again by every run
+struct Workload {
+    std::vector<ProcessInput> inputs;
+    std::string stream_file;
+    size_t n_stream_processes = 0;
+};
+
+// settings shared by every run of a sweep
+struct SimOptions {
+    char queue_option = 'h';
+    output_format format = output_format::TEXT;
+    int n_cpus = 1;
+    LoadBalancer balancer;
+    bool latency = false;  // -l: wait and response time percentiles
+    std::string trace_file;  // -t: binary trace instead of -v text
+    int checkpoint_clock = -1;
+    std::string checkpoint_file;  // -k <clock>:<file>
+    std::string resume_file;      // -r
+};
+
+// output file of run i out of n_runs: the file itself for a single run,
+// file.<i> for each run of a sweep
+std::string run_file(const std::string& file, size_t i, size_t n_runs) {
+    if (file.empty() || n_runs == 1) return file;
+    return file + "." + std::to_string(i);
+}
+
+// with a trace file the loop writes binary records to it instead of -v text
+void run_loop(const std::string& spec, DES* des, std::vector<CPU>& cpus,
+              const SimOptions& options, RandGenerator* rand_generator,
+              FILE* out, const std::string& trace_file,
+              const Checkpoint* checkpoint) {
+    if (!trace_file.empty()) {
+        TraceWriter* tracer = TraceWriter::open(trace_file.c_str());
+        if (!tracer) {
+            printf("Cannot open trace file %s. Exiting.\n",
+                   trace_file.c_str());
+            exit(EXIT_FAILURE);
+        }
+        policy_loop(spec, des, cpus, options.balancer, rand_generator, *tracer,
+                    checkpoint);
+        delete tracer;
+    } else if (verbose_mode) {
+        TextTracer tracer(out);
+        policy_loop(spec, des, cpus, options.balancer, rand_generator, tracer,
+                    checkpoint);
+    } else {
+        NullTracer tracer;
+        policy_loop(spec, des, cpus, options.balancer, rand_generator, tracer,
+                    checkpoint);
+    }
+}
+
+// One complete simulation for run i of a sweep of n_runs; the runs of a sweep
+// share only the read-only workload and random table. A run resumed from a
+// checkpoint takes its processes from there instead of the workload.
+void run_simulation(const std::string& spec, EventQueue* event_queue,
+                    const Workload& workload, const SimOptions& options,
+                    RandGenerator rand_generator, FILE* out, size_t i = 0,
+                    size_t n_runs = 1) {
+    std::vector<CPU> cpus;
+    for (int c = 0; c < options.n_cpus; c++) {
+        cpus.push_back(CPU(make_scheduler(spec, &rand_generator)));
+    }
+    Scheduler* scheduler = cpus[0].scheduler;
+
+    std::string trace_file = run_file(options.trace_file, i, n_runs);
+    Checkpoint checkpoint = {options.checkpoint_clock,
+                             run_file(options.checkpoint_file, i, n_runs),
+                             spec};
+    const Checkpoint* take_checkpoint =
+        checkpoint.file.empty() ? nullptr : &checkpoint;
+
+    ProcessTable processes;
+    rand_generator.reset();
+    if (!options.resume_file.empty()) {
+        DES des(&processes, event_queue);
+        restore_checkpoint(options.resume_file, spec, &des, cpus, &processes,
+                           &rand_generator);
+
+        run_loop(spec, &des, cpus, options, &rand_generator, out, trace_file,
+                 take_checkpoint);
+        report_summary(&des, scheduler, out, options.format,
+                       options.latency);
+    } else if (workload.stream_file.empty()) {
+        create_processes(workload.inputs, &rand_generator, scheduler->maxprio,
+                         &processes);
+        DES des(&processes, event_queue);
+
+        run_loop(spec, &des, cpus, options, &rand_generator, out, trace_file,
+                 take_checkpoint);
+        report_summary(&des, scheduler, out, options.format,
+                       options.latency);
+    } else {
+        processes.reserve(workload.n_stream_processes);
+        ProcessStream arrivals(workload.stream_file, rand_generator,
+                               scheduler->maxprio, &processes);
+        rand_generator.skip(workload.n_stream_processes);
+        DES des(&arrivals, &processes, event_queue);
+
+        run_loop(spec, &des, cpus, options, &rand_generator, out, trace_file,
+                 take_checkpoint);
+        report_summary(&des, scheduler, out, options.format,
+                       options.latency);
+    }
 
-        finishtime = std::max(finishtime, p->finish_time);
+    for (auto& cpu : cpus) {
+        delete cpu.scheduler;
     }
+}
 
-    double avg_tat = total_tat / num_processes;
-    double avg_wait = total_wait / num_processes;
+// Runs the sweep on n_threads workers. Each worker builds its own DES, event
+// queue and random cursor and writes into a private buffer; the buffers are
+// printed in spec order once all runs are done.
+void run_sweep_parallel(const std::vector<std::string>& specs,
+                        const Workload& workload, const SimOptions& options,
+                        const RandGenerator& rand_generator, int n_threads) {
+    std::vector<char*> outputs(specs.size(), nullptr);
+    std::vector<size_t> output_sizes(specs.size(), 0);
+    std::atomic<size_t> next_job(0);
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next_job++) < specs.size()) {
+            FILE* out = open_memstream(&outputs[i], &output_sizes[i]);
+            EventQueue* event_queue = make_event_queue(options.queue_option);
+            run_simulation(specs[i], event_queue, workload, options,
+                           rand_generator, out, i, specs.size());
+            delete event_queue;
+            fclose(out);
+        }
+    };
 
-    double cpu_util = 100.0 * (cpu_time / (double)finishtime);
-    double io_util = 100.0 * (des->total_io_time / (double)finishtime);
-    double throughput = 100.0 * (num_processes / (double)finishtime);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < n_threads; t++) {
+        workers.emplace_back(worker);
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
 
-    printf("SUM: %d %.2lf %.2lf %.2lf %.2lf %.3lf\n", finishtime, cpu_util,
-           io_util, avg_tat, avg_wait, throughput);
+    for (size_t i = 0; i < specs.size(); i++) {
+        fwrite(outputs[i], 1, output_sizes[i], stdout);
+        free(outputs[i]);
+    }
 }
 
+#ifndef SCHEDULER_NO_MAIN
 int main(int argc, char** argv) {
     int opt;
     char* scheduler_option = NULL;
     char* inputfile = NULL;
     char* randomfile = NULL;
+    bool report_rss = false;
+    int n_threads = 1;
+    bool stream_input = false;
+    SimOptions options;
+    options.balancer.policy = balance_policy::STEAL;
 
     if (argc < 4) {
-        printf("Usage: %s -s <scheduler_option> <inputfile> <randomfile>\n",
-               argv[0]);
+        printf(
+            "Usage: %s [-v] [-m] [-a] [-l] [-t tracefile] "
+            "[-k clock:checkpoint] [-r checkpoint] [-q l|h|c] "
+            "[-j threads] [-o jsonl|bin] [-c cpus] "
+            "[-b none|steal|periodic:<ticks>] "
+            "-s <scheduler_option>[,...] <inputfile> <randomfile>\n",
+            argv[0]);
         exit(EXIT_FAILURE);
     }
-    while ((opt = getopt(argc, argv, "vs:")) != -1) {
+    while ((opt = getopt(argc, argv, "vmals:q:j:o:c:b:t:k:r:")) != -1) {
         switch (opt) {
             case 'v':
                 verbose_mode = 1;
@@ -543,6 +2386,64 @@ int main(int argc, char** argv) {
             case 's':
                 scheduler_option = optarg;
                 break;
+            case 'q':
+                options.queue_option = optarg[0];
+                break;
+            case 'm':
+                report_rss = true;
+                break;
+            case 'j':
+                n_threads = std::max(1, atoi(optarg));
+                break;
+            case 'a':
+                stream_input = true;
+                break;
+            case 'l':
+                options.latency = true;
+                break;
+            case 't':
+                options.trace_file = optarg;
+                break;
+            case 'k': {
+                const char* file = strchr(optarg, ':');
+                if (!file || file[1] == 0 || atoi(optarg) < 0) {
+                    printf("Invalid checkpoint option provided. Exiting.\n");
+                    exit(EXIT_FAILURE);
+                }
+                options.checkpoint_clock = atoi(optarg);
+                options.checkpoint_file = file + 1;
+                break;
+            }
+            case 'r':
+                options.resume_file = optarg;
+                break;
+            case 'o':
+                if (!strcmp(optarg, "jsonl")) {
+                    options.format = output_format::JSONL;
+                } else if (!strcmp(optarg, "bin")) {
+                    options.format = output_format::BINARY;
+                } else {
+                    printf("Invalid output format provided. Exiting.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                options.n_cpus = std::max(1, atoi(optarg));
+                break;
+            case 'b':
+                if (!strcmp(optarg, "none")) {
+                    options.balancer.policy = balance_policy::NONE;
+                } else if (!strcmp(optarg, "steal")) {
+                    options.balancer.policy = balance_policy::STEAL;
+                } else if (!strncmp(optarg, "periodic:", 9) &&
+                           atoi(optarg + 9) > 0) {
+                    options.balancer.policy = balance_policy::PERIODIC;
+                    options.balancer.interval = atoi(optarg + 9);
+                } else {
+                    printf("Invalid load balancer provided. Exiting.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
         }
     }
 
@@ -554,48 +2455,56 @@ int main(int argc, char** argv) {
     inputfile = argv[optind];
     randomfile = argv[optind + 1];
 
-    Scheduler* scheduler;
-    switch (scheduler_option[0]) {
-        case 'F':
-            scheduler = new FCFS();
-            break;
-        case 'L':
-            scheduler = new LCFS();
-            break;
-        case 'S':
-            scheduler = new SRTF();
-            break;
-        case 'R':
-            scheduler = new RR(atoi(&scheduler_option[1]));
-            break;
-        case 'P':
-            if (strchr(scheduler_option, ':')) {
-                char* quantum_str = strtok(&scheduler_option[1], ":");
-                char* maxprio_str = strtok(NULL, ":");
-                scheduler = new PRIO(atoi(quantum_str), atoi(maxprio_str));
-            } else {
-                scheduler = new PRIO(atoi(&scheduler_option[1]));
-            }
-            break;
-        case 'E':
-            if (strchr(scheduler_option, ':')) {
-                char* quantum_str = strtok(&scheduler_option[1], ":");
-                char* maxprio_str = strtok(NULL, ":");
-                scheduler = new PREPRIO(atoi(quantum_str), atoi(maxprio_str));
-            } else {
-                scheduler = new PREPRIO(atoi(&scheduler_option[1]));
-            }
-            break;
-        default:
+    // a comma separated list of specs runs a sweep over the same input
+    std::vector<std::string> specs;
+    std::istringstream spec_list(scheduler_option);
+    std::string spec;
+    while (std::getline(spec_list, spec, ',')) {
+        Scheduler* scheduler = make_scheduler(spec);
+        if (!scheduler) {
             printf("Invalid scheduler option provided. Exiting.\n");
             exit(EXIT_FAILURE);
+        }
+        delete scheduler;
+        specs.push_back(spec);
+    }
+
+    // the queue is empty again after each run and is reused by the next one
+    EventQueue* event_queue = make_event_queue(options.queue_option);
+    if (!event_queue) {
+        printf("Invalid event queue option provided. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // the position in a streamed input file is not part of a checkpoint
+    if (stream_input && (!options.checkpoint_file.empty() ||
+                         !options.resume_file.empty())) {
+        printf("Checkpoints are not supported with -a. Exiting.\n");
+        exit(EXIT_FAILURE);
     }
 
     auto rand_generator = RandGenerator(randomfile);
-    auto process_array =
-        create_process_array(inputfile, &rand_generator, scheduler->maxprio);
-    auto des = DES(process_array);
+    Workload workload;
+    if (!options.resume_file.empty()) {
+        // the processes come from the checkpoint
+    } else if (stream_input) {
+        workload.stream_file = inputfile;
+        workload.n_stream_processes = count_lines(inputfile);
+    } else {
+        workload.inputs = read_process_inputs(inputfile);
+    }
 
-    simulation_loop(&des, scheduler, &rand_generator);
-    print_summary(&des, scheduler);
+    if (n_threads > 1 && specs.size() > 1) {
+        run_sweep_parallel(specs, workload, options, rand_generator,
+                           n_threads);
+    } else {
+        for (size_t i = 0; i < specs.size(); i++) {
+            run_simulation(specs[i], event_queue, workload, options,
+                           rand_generator, stdout, i, specs.size());
+        }
+    }
+    if (report_rss) {
+        print_peak_rss();
+    }
 }
+#endif
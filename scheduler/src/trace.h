@@ -0,0 +1,183 @@
+// Scheduler trace records. The simulation loop hands one record per
+// transition to a tracer chosen at compile time: NullTracer compiles away,
+// TextTracer prints the -v lines as it goes and TraceWriter streams binary
+// records to a file through a ring buffer and a writer thread. tracedump turns
+// such a file back into the -v text.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+enum class process_transition : uint8_t {
+    CREATED_TO_READY,
+    READY_TO_RUNNING,
+    RUNNING_TO_BLOCKED,
+    BLOCKED_TO_READY,
+    RUNNING_TO_READY,
+    RUNNING_TO_DONE
+};
+
+// one -v line; burst is the CPU burst, or the I/O burst on RUNNING_TO_BLOCKED
+struct TraceRecord {
+    int32_t clock, pid, time_in_state;
+    int32_t transition;  // process_transition
+    int32_t burst, rem, prio;
+    int32_t reserved;
+};
+
+// a record with every field set, so the reserved bytes written to a trace
+// file are always defined
+inline TraceRecord make_trace_record(int32_t clock, int32_t pid,
+                                     int32_t time_in_state,
+                                     process_transition transition,
+                                     int32_t burst = 0, int32_t rem = 0,
+                                     int32_t prio = 0) {
+    TraceRecord r;
+    r.clock = clock;
+    r.pid = pid;
+    r.time_in_state = time_in_state;
+    r.transition = (int32_t)transition;
+    r.burst = burst;
+    r.rem = rem;
+    r.prio = prio;
+    r.reserved = 0;
+    return r;
+}
+
+// A trace file is a TraceHeader followed by TraceRecords, native endianness.
+struct TraceHeader {
+    char magic[4];  // "STRC"
+    uint32_t version;
+    uint32_t record_size;
+};
+
+// prints r exactly as the simulation loop did under -v
+inline void format_trace_record(FILE* out, const TraceRecord& r) {
+    switch ((process_transition)r.transition) {
+        case process_transition::CREATED_TO_READY:
+            fprintf(out, "%d %d %d: CREATED -> READY\n", r.clock, r.pid,
+                    r.time_in_state);
+            break;
+        case process_transition::READY_TO_RUNNING:
+            fprintf(out, "%d %d %d: READY -> RUNNG cb=%d rem=%d prio=%d\n",
+                    r.clock, r.pid, r.time_in_state, r.burst, r.rem, r.prio);
+            break;
+        case process_transition::RUNNING_TO_READY:
+            fprintf(out, "%d %d %d: RUNNG -> READY cb=%d rem=%d prio=%d\n",
+                    r.clock, r.pid, r.time_in_state, r.burst, r.rem, r.prio);
+            break;
+        case process_transition::RUNNING_TO_BLOCKED:
+            fprintf(out, "%d %d %d: RUNNG -> BLOCK  ib=%d rem=%d\n", r.clock,
+                    r.pid, r.time_in_state, r.burst, r.rem);
+            break;
+        case process_transition::BLOCKED_TO_READY:
+            fprintf(out, "%d %d %d: BLOCK -> READY\n", r.clock, r.pid,
+                    r.time_in_state);
+            break;
+        case process_transition::RUNNING_TO_DONE:
+            fprintf(out, "%d %d %d: Done\n", r.clock, r.pid, r.time_in_state);
+            break;
+    }
+}
+
+struct NullTracer {
+    void record(const TraceRecord&) {}
+};
+
+struct TextTracer {
+    FILE* out;
+
+    explicit TextTracer(FILE* out) : out(out) {}
+
+    void record(const TraceRecord& r) { format_trace_record(out, r); }
+};
+
+// Single producer, single consumer ring of trace records. The simulation
+// thread only copies a record into the ring; the writer thread wakes up once
+// per batch and writes whole spans of the ring to the file. A full ring makes
+// the producer wait for the writer rather than drop records.
+class TraceWriter {
+   public:
+    static const size_t capacity = 1 << 16;  // records, a power of two
+    static const size_t batch = 1 << 12;
+
+    // nullptr if the file cannot be created
+    static TraceWriter* open(const char* filename) {
+        FILE* file = fopen(filename, "wb");
+        if (!file) return nullptr;
+        TraceHeader header = {};
+        memcpy(header.magic, "STRC", 4);
+        header.version = 1;
+        header.record_size = sizeof(TraceRecord);
+        fwrite(&header, sizeof(header), 1, file);
+        return new TraceWriter(file);
+    }
+
+    ~TraceWriter() {
+        done.store(true, std::memory_order_release);
+        wakeup.notify_one();
+        writer.join();
+        fclose(file);
+    }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    void record(const TraceRecord& r) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - tail_seen == capacity) {
+            while (h - (tail_seen = tail.load(std::memory_order_acquire)) ==
+                   capacity) {
+                wakeup.notify_one();
+                std::this_thread::yield();
+            }
+        }
+        ring[h & (capacity - 1)] = r;
+        head.store(h + 1, std::memory_order_release);
+        if ((h + 1) % batch == 0) wakeup.notify_one();
+    }
+
+   private:
+    FILE* file;
+    std::vector<TraceRecord> ring;
+    std::atomic<size_t> head{0};  // next slot the producer fills
+    std::atomic<size_t> tail{0};  // next slot the writer writes out
+    size_t tail_seen = 0;         // producer's copy of tail
+    std::atomic<bool> done{false};
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread writer;
+
+    explicit TraceWriter(FILE* file)
+        : file(file), ring(capacity), writer(&TraceWriter::drain, this) {}
+
+    void drain() {
+        while (true) {
+            bool finished = done.load(std::memory_order_acquire);
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            if (t == h) {
+                if (finished) return;
+                // a missed notify only delays the writer by the timeout
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeup.wait_for(lock, std::chrono::milliseconds(1));
+                continue;
+            }
+            size_t begin = t & (capacity - 1);
+            size_t n = std::min(h - t, capacity - begin);
+            fwrite(&ring[begin], sizeof(TraceRecord), n, file);
+            tail.store(t + n, std::memory_order_release);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,37 @@
+// Decodes a binary scheduler trace (scheduler -t) into the text that -v
+// prints for the same run.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "../../common/fastio.h"
+#include "trace.h"
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <tracefile>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    MappedFile file(argv[1]);
+    size_t size = file.end() - file.begin();
+    TraceHeader header;
+    if (size < sizeof(header)) {
+        printf("Not a scheduler trace. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(&header, file.begin(), sizeof(header));
+    if (memcmp(header.magic, "STRC", 4) || header.version != 1 ||
+        header.record_size != sizeof(TraceRecord)) {
+        printf("Not a scheduler trace. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    const char* records = file.begin() + sizeof(header);
+    size_t n_records = (size - sizeof(header)) / sizeof(TraceRecord);
+    for (size_t i = 0; i < n_records; i++) {
+        TraceRecord r;
+        memcpy(&r, records + i * sizeof(TraceRecord), sizeof(r));
+        format_trace_record(stdout, r);
+    }
+}
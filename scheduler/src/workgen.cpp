@@ -0,0 +1,103 @@
+// Generates a scheduler input file of n processes with Poisson, bursty or
+// diurnal arrivals (see workgen.h). Without an output file the lines go to
+// stdout.
+#include <unistd.h>
+
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "workgen.h"
+
+int main(int argc, char** argv) {
+    int opt;
+    GeneratorOptions options;
+    bool mean_given = false;
+
+    if (argc < 2) {
+        printf(
+            "Usage: %s [-a poisson|bursty|diurnal] [-m mean_interarrival] "
+            "[-t tc_max] [-c cb_max] [-i io_max] [-b burst_size] "
+            "[-p period] [-w amplitude] [-s seed] <processes> [outputfile]\n"
+            "Arrival times must fit in an int: processes * mean_interarrival "
+            "stays below %d. Without -m the mean is 100, lowered as needed "
+            "for large process counts.\n",
+            argv[0], INT_MAX);
+        exit(EXIT_FAILURE);
+    }
+    while ((opt = getopt(argc, argv, "a:m:t:c:i:b:p:w:s:")) != -1) {
+        switch (opt) {
+            case 'a':
+                if (!strcmp(optarg, "poisson")) {
+                    options.arrivals = arrival_pattern::POISSON;
+                } else if (!strcmp(optarg, "bursty")) {
+                    options.arrivals = arrival_pattern::BURSTY;
+                } else if (!strcmp(optarg, "diurnal")) {
+                    options.arrivals = arrival_pattern::DIURNAL;
+                } else {
+                    printf("Invalid arrival pattern provided. Exiting.\n");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'm':
+                options.mean_interarrival = atof(optarg);
+                mean_given = true;
+                break;
+            case 't':
+                options.tc_max = atoi(optarg);
+                break;
+            case 'c':
+                options.cb_max = atoi(optarg);
+                break;
+            case 'i':
+                options.io_max = atoi(optarg);
+                break;
+            case 'b':
+                options.burst_size = atof(optarg);
+                break;
+            case 'p':
+                options.period = atof(optarg);
+                break;
+            case 'w':
+                options.amplitude = atof(optarg);
+                break;
+            case 's':
+                options.seed = strtoull(optarg, nullptr, 10);
+                break;
+        }
+    }
+
+    if (optind >= argc || atoll(argv[optind]) < 1) {
+        printf("No process count provided. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (options.mean_interarrival <= 0 || options.period <= 0 ||
+        options.amplitude < 0 || options.amplitude > 1) {
+        printf("Invalid arrival parameters provided. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t n_processes = atoll(argv[optind]);
+    if (!mean_given) {
+        options.mean_interarrival = default_mean_interarrival(n_processes);
+    }
+
+    FILE* out = stdout;
+    if (optind + 1 < argc) {
+        out = fopen(argv[optind + 1], "w");
+        if (!out) {
+            printf("Cannot open output file %s. Exiting.\n", argv[optind + 1]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if (!write_workload(options, n_processes, out)) {
+        fprintf(stderr,
+                "Arrival times overflow the simulation clock (lower -m) or "
+                "the output failed. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (out != stdout && fclose(out) != 0) {
+        printf("Cannot write output file. Exiting.\n");
+        exit(EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,136 @@
+// Synthetic scheduler inputs: arrival-sorted "at tc cb io" lines, one process
+// per line, as the scheduler reads them. The arrival pattern is chosen per
+// workload and all patterns share the same mean interarrival time, so a
+// bursty or diurnal workload offers the same long-run load as a Poisson one.
+// Processes are produced one at a time, so any number can be written in
+// constant memory.
+#ifndef WORKGEN_H
+#define WORKGEN_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+
+enum class arrival_pattern { POISSON, BURSTY, DIURNAL };
+
+struct GeneratorOptions {
+    arrival_pattern arrivals = arrival_pattern::POISSON;
+    double mean_interarrival = 100;  // see default_mean_interarrival
+    int tc_max = 500, cb_max = 40, io_max = 60;  // drawn uniformly from 1..max
+    // BURSTY: mean processes per burst; arrivals inside a burst are ten
+    // times denser than the mean and the bursts are separated by idle gaps
+    double burst_size = 20;
+    // DIURNAL: the arrival rate swings by +-amplitude around the mean over a
+    // period of `period` ticks
+    double period = 100000;
+    double amplitude = 0.8;
+    uint64_t seed = 1;
+};
+
+struct GeneratedProcess {
+    long at;
+    int tc, cb, io;
+};
+
+class WorkloadGenerator {
+   public:
+    explicit WorkloadGenerator(const GeneratorOptions& options)
+        : options(options), rng(options.seed) {}
+
+    GeneratedProcess next() {
+        clock += interarrival();
+        GeneratedProcess p;
+        p.at = (long)clock;
+        p.tc = uniform(options.tc_max);
+        p.cb = uniform(options.cb_max);
+        p.io = uniform(options.io_max);
+        return p;
+    }
+
+   private:
+    GeneratorOptions options;
+    std::mt19937_64 rng;
+    double clock = 0;
+    long left_in_burst = 0;
+
+    int uniform(int max) {
+        return std::uniform_int_distribution<int>(1, std::max(1, max))(rng);
+    }
+
+    double exponential(double mean) {
+        return std::exponential_distribution<double>(1 / mean)(rng);
+    }
+
+    double interarrival() {
+        double mean = options.mean_interarrival;
+        switch (options.arrivals) {
+            case arrival_pattern::POISSON:
+                break;
+            case arrival_pattern::BURSTY: {
+                // a geometric number of arrivals 0.1 * mean apart, then an
+                // idle gap that brings the average back to mean
+                double dense = 0.1 * mean;
+                if (left_in_burst > 0) {
+                    left_in_burst--;
+                    return exponential(dense);
+                }
+                double p = 1 / std::max(1.0, options.burst_size);
+                left_in_burst = std::geometric_distribution<long>(p)(rng);
+                return exponential(options.burst_size * (mean - dense)) +
+                       exponential(dense);
+            }
+            case arrival_pattern::DIURNAL: {
+                // thinning of a Poisson process at the peak rate
+                double peak = (1 + options.amplitude) / mean;
+                double omega = 2 * acos(-1.0) / options.period;
+                double t = clock;
+                while (true) {
+                    t += exponential(1 / peak);
+                    double rate =
+                        (1 + options.amplitude * sin(omega * t)) / mean;
+                    if (std::uniform_real_distribution<double>()(rng) * peak <
+                        rate) {
+                        return t - clock;
+                    }
+                }
+            }
+        }
+        return exponential(mean);
+    }
+};
+
+// The default mean interarrival time for n processes: 100 ticks, lowered for
+// large n so the last arrival, about n * mean, stays within the scheduler's
+// int clock with a tenth to spare for the spread of the arrivals.
+inline double default_mean_interarrival(uint64_t n) {
+    return std::min(100.0, 0.9 * INT_MAX / n);
+}
+
+// Writes n processes as scheduler input lines; false if an arrival time no
+// longer fits the scheduler's int clock or the output fails.
+inline bool write_workload(const GeneratorOptions& options, uint64_t n,
+                           FILE* out) {
+    WorkloadGenerator generator(options);
+    std::string buffer;
+    char line[64];
+    for (uint64_t i = 0; i < n; i++) {
+        GeneratedProcess p = generator.next();
+        if (p.at > INT_MAX) return false;
+        int length = snprintf(line, sizeof(line), "%ld %d %d %d\n", p.at, p.tc,
+                              p.cb, p.io);
+        buffer.append(line, length);
+        if (buffer.size() > (1 << 16)) {
+            if (fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()) {
+                return false;
+            }
+            buffer.clear();
+        }
+    }
+    return fwrite(buffer.data(), 1, buffer.size(), out) == buffer.size();
+}
+
+#endif